@@ -1,127 +1,489 @@
 #ifndef BINOMIAL_HEAP_H
 #define BINOMIAL_HEAP_H
 
+#include <algorithm>
+#include <array>
+#include <iterator>
 #include <vector>
 #include <memory>
-#include <list>
+#include <new>
 #include <optional>
 #include <iostream>
+#include <type_traits>
+#include <utility>
 
 
+// fixed size slots cut from slabs that double in size. freed slots go on a free list and are reused
+// before a new slab is cut, so a pool that has been through its peak size allocates nothing more
+template<typename X> class binomial_heap_pool {
+    union slot {
+        X value;
+        slot *next_free;
+
+        slot() {}
+        ~slot() {}
+    };
+
+    std::vector<std::unique_ptr<slot[]>> slabs;
+    slot *free_head, *free_tail;
+    size_t slab_size, num_free;
+
+    // puts a slab of at least size slots in front of the free list
+    void grow(size_t size) {
+        size = std::max(size, slab_size);
+        slabs.push_back(std::make_unique<slot[]>(size));
+
+        slot *slab = slabs.back().get();
+        for(size_t k=0; k+1<size; ++k) slab[k].next_free = &slab[k+1];
+        slab[size-1].next_free = free_head;
+
+        if(!free_head) free_tail = &slab[size-1];
+        free_head = slab;
+        num_free += size;
+        slab_size = 2 * size;
+    }
+
+    public:
+    binomial_heap_pool():
+        slabs{},
+        free_head{nullptr},
+        free_tail{nullptr},
+        slab_size{64},
+        num_free{0}
+    {}
+
+    binomial_heap_pool(binomial_heap_pool &&other):
+        slabs{std::move(other.slabs)},
+        free_head{std::exchange(other.free_head, nullptr)},
+        free_tail{std::exchange(other.free_tail, nullptr)},
+        slab_size{std::exchange(other.slab_size, 64)},
+        num_free{std::exchange(other.num_free, 0)}
+    {}
+
+    binomial_heap_pool &operator=(binomial_heap_pool &&other) {
+        slabs = std::move(other.slabs);
+        free_head = std::exchange(other.free_head, nullptr);
+        free_tail = std::exchange(other.free_tail, nullptr);
+        slab_size = std::exchange(other.slab_size, 64);
+        num_free = std::exchange(other.num_free, 0);
+
+        return *this;
+    }
+
+    // makes sure the next count slots come without cutting another slab
+    void reserve(size_t count) {
+        if(num_free < count) grow(count - num_free);
+    }
+
+    template<typename... Args> X *make(Args&&... args) {
+        if(!free_head) grow(slab_size);
+
+        slot *s = free_head;
+        free_head = s->next_free;
+        if(!free_head) free_tail = nullptr;
+        --num_free;
+
+        return new(&s->value) X(std::forward<Args>(args)...);
+    }
+
+    // assumes x came from this pool, or from one it absorbed
+    void release(X *x) {
+        x->~X();
+
+        slot *s = reinterpret_cast<slot*>(x);
+        s->next_free = free_head;
+        free_head = s;
+        if(!free_tail) free_tail = s;
+        ++num_free;
+    }
+
+    // takes over the slabs of other, so whatever other handed out stays valid. O(number of slabs).
+    // each pool keeps growing at its own pace, other starts over from the smallest slab
+    void absorb(binomial_heap_pool &&other) {
+        for(auto &slab : other.slabs) slabs.push_back(std::move(slab));
+        other.slabs.clear();
+
+        if(other.free_head) {
+            if(free_tail) free_tail->next_free = other.free_head;
+            else free_head = other.free_head;
+            free_tail = other.free_tail;
+        }
+
+        other.free_head = other.free_tail = nullptr;
+        num_free += std::exchange(other.num_free, 0);
+        other.slab_size = 64;
+    }
+};
+
 template<typename T, typename Compare = std::less<T>> class binomial_heap {
-    struct binomial_heap_node {
-        using children_t = typename std::vector<std::unique_ptr<binomial_heap_node>>;
+    struct binomial_heap_node;
 
-        size_t rank;
+    // keys live in items that move between nodes as they sift, so a handle to an item stays good
+    // wherever its key ends up. the item always knows the node currently holding it
+    struct binomial_heap_item {
         T key;
-        children_t children;
+        binomial_heap_node *owner;
 
-        template<typename X=T> binomial_heap_node(X &&key, children_t children):
-            rank{0},
+        template<typename X=T> binomial_heap_item(X &&key):
             key{std::forward<X>(key)},
-            children{std::move(children)}
+            owner{nullptr}
         {}
+    };
+
+    // left child, right sibling. the children of a node, highest rank first, and the roots are both
+    // doubly linked sibling lists, so linking, unlinking and promoting children never allocate
+    struct binomial_heap_node {
+        size_t rank;
+        binomial_heap_item *item;
+        binomial_heap_node *parent, *child, *prev, *next;
+
+        binomial_heap_node(binomial_heap_item *item):
+            rank{0},
+            item{item},
+            parent{nullptr},
+            child{nullptr},
+            prev{nullptr},
+            next{nullptr}
+        {
+            this->item->owner = this;
+        }
 
-        template<typename X> void merge(X &&other) {
-            children.emplace_back(std::forward<X>(other));
+        const T &key() const { return item->key; }
+
+        void merge(binomial_heap_node *other) {
+            other->parent = this;
+            other->prev = nullptr;
+            other->next = child;
+            if(child) child->prev = other;
+            child = other;
 
             ++rank;
         }
 
+        void swap_items(binomial_heap_node &other) {
+            std::swap(item, other.item);
+            item->owner = this;
+            other.item->owner = &other;
+        }
+
         void print(size_t depth=0) const {
-            std::cout << '(' << rank << ", " << key << ") " << std::endl;
-            for(auto &it : children) {
+            std::cout << '(' << rank << ", " << key() << ") " << std::endl;
+            for(auto it = child; it; it = it->next) {
                 for(size_t k=0; k<=depth; ++k) std::cout << "  ";
                 it->print(depth+1);
             }
         }
     };
 
-    using node_t = typename std::unique_ptr<binomial_heap_node>;
-
     Compare comp;
-    std::list<node_t> the_binomial_tree;
-    std::optional<T> the_max_or_min;
+    binomial_heap_pool<binomial_heap_node> nodes;
+    binomial_heap_pool<binomial_heap_item> items;
+    // scratch for pop_k, kept so that repeated calls do not allocate. the key is kept next to its node
+    // to save a load on every comparison
+    std::vector<std::pair<const T*, binomial_heap_node*>> candidates;
+    // head of the root list
+    binomial_heap_node *roots;
+    // the root holding the max or min, the roots hold the best key of their trees so it is always one of them
+    binomial_heap_node *the_target;
+    size_t num_items;
 
-    node_t merge(node_t first, node_t second) const {
-        if(comp(first->key, second->key)) {
-            first->merge(second.release());
+    binomial_heap_node *merge(binomial_heap_node *first, binomial_heap_node *second) const {
+        if(comp(first->key(), second->key())) {
+            first->merge(second);
 
             return first;
         }
         else {
-            second->merge(first.release());
+            second->merge(first);
 
             return second;
         }
     }
 
-    auto get_target_it() {
-        auto target_it = the_binomial_tree.front();
-        for(auto it = ++the_binomial_tree.begin(); it!=the_binomial_tree.end(); ++it) {
-            if(comp(it->key, target_it->key)) target_it = it;
+    void add_root(binomial_heap_node *root) {
+        root->parent = nullptr;
+        root->prev = nullptr;
+        root->next = roots;
+        if(roots) roots->prev = root;
+        roots = root;
+    }
+
+    void unlink_root(binomial_heap_node *root) {
+        if(root->prev) root->prev->next = root->next;
+        else roots = root->next;
+        if(root->next) root->next->prev = root->prev;
+    }
+
+    void offer_target(binomial_heap_node *root) {
+        if(!the_target || comp(root->key(), the_target->key())) the_target = root;
+    }
+
+    // swaps the item with its ancestors while it beats them, or all the way to the root if forced
+    binomial_heap_node *sift_up(binomial_heap_node *node, bool to_root=false) {
+        while(node->parent && (to_root || comp(node->key(), node->parent->key()))) {
+            node->swap_items(*node->parent);
+            node = node->parent;
+        }
+
+        return node;
+    }
+
+    // takes the root out of the heap, its subtrees become roots in turn. the node goes back to the pool
+    binomial_heap_item *remove_root(binomial_heap_node *root) {
+        unlink_root(root);
+        for(binomial_heap_node *child = root->child, *next; child; child = next) {
+            next = child->next;
+            add_root(child);
         }
 
-        return target_it;
+        binomial_heap_item *item = root->item;
+        nodes.release(root);
+        --num_items;
+
+        return item;
+    }
+
+    void destroy(binomial_heap_node *first) {
+        for(binomial_heap_node *node = first, *next; node; node = next) {
+            next = node->next;
+
+            destroy(node->child);
+            items.release(node->item);
+            nodes.release(node);
+        }
     }
 
     public:
-    template<typename X=T> void insert(X &&key) {
-        the_binomial_tree.emplace_back(
-                std::make_unique<binomial_heap_node>(
-                    std::forward<X>(key), typename binomial_heap_node::children_t()
-                    )
-                );
+    // refers to an inserted key until that key is deleted
+    class handle {
+        binomial_heap_item *item;
+
+        friend class binomial_heap;
+
+        handle(binomial_heap_item *item):
+            item{item}
+        {}
+
+        public:
+        handle():
+            item{nullptr}
+        {}
+
+        const T &key() const { return item->key; }
+    };
+
+    binomial_heap():
+        comp{},
+        nodes{},
+        items{},
+        candidates{},
+        roots{nullptr},
+        the_target{nullptr},
+        num_items{0}
+    {}
+
+    binomial_heap(binomial_heap &&other):
+        comp{std::move(other.comp)},
+        nodes{std::move(other.nodes)},
+        items{std::move(other.items)},
+        candidates{},
+        roots{std::exchange(other.roots, nullptr)},
+        the_target{std::exchange(other.the_target, nullptr)},
+        num_items{std::exchange(other.num_items, 0)}
+    {}
+
+    binomial_heap &operator=(binomial_heap &&other) {
+        if(this == &other) return *this;
+
+        destroy(roots);
+
+        comp = std::move(other.comp);
+        nodes = std::move(other.nodes);
+        items = std::move(other.items);
+        roots = std::exchange(other.roots, nullptr);
+        the_target = std::exchange(other.the_target, nullptr);
+        num_items = std::exchange(other.num_items, 0);
+
+        return *this;
+    }
+
+    // the slabs go with the pools, only the keys need destroying
+    ~binomial_heap() {
+        if constexpr(!std::is_trivially_destructible_v<T>) destroy(roots);
+    }
+
+    template<typename X=T> handle insert(X &&key) {
+        binomial_heap_item *item = items.make(std::forward<X>(key));
+        binomial_heap_node *node = nodes.make(item);
+
+        add_root(node);
+        offer_target(node);
+        ++num_items;
+
+        return handle{item};
     }
 
+    // adds every key in the range, carrying equal ranks together like a binary counter as they come, so
+    // the trees are assembled in O(n) with at most one tree per rank. no handles are kept to these keys
+    template<typename It> void build(It first, It last) {
+        if constexpr(std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
+            const auto count = static_cast<size_t>(std::distance(first, last));
+            items.reserve(count);
+            nodes.reserve(count);
+        }
+
+        std::array<binomial_heap_node*, sizeof(size_t) * 8> forest{};
+        size_t num_ranks = 0;
+
+        for(; first != last; ++first) {
+            binomial_heap_node *current = nodes.make(items.make(*first));
+            ++num_items;
+
+            while(forest[current->rank]) {
+                binomial_heap_node *other = std::exchange(forest[current->rank], nullptr);
+                current = merge(current, other);
+            }
+
+            forest[current->rank] = current;
+            num_ranks = std::max(num_ranks, current->rank + 1);
+        }
+
+        for(size_t k=0; k<num_ranks; ++k) {
+            if(forest[k]) add_root(forest[k]);
+        }
+
+        clean();
+    }
+
+    // O(1)
     std::optional<T> max_or_min() const {
-        return the_max_or_min;
+        if(the_target) return the_target->key();
+        else return {};
     }
 
-    // assumes non empty
+    size_t size() const { return num_items; }
+    bool empty() const { return num_items == 0; }
+
+    // assumes key does not lose against the current key of h, O(log n)
+    template<typename X=T> void decrease_key(handle h, X &&key) {
+        h.item->key = std::forward<X>(key);
+
+        binomial_heap_node *node = sift_up(h.item->owner);
+        if(!node->parent) offer_target(node);
+    }
+
+    // O(log n), the key is sifted to the root of its tree and the root is split into its subtrees
+    void erase(handle h) {
+        binomial_heap_node *root = sift_up(h.item->owner, true);
+
+        if(root == the_target) {
+            delete_max_or_min();
+        }
+        else {
+            items.release(remove_root(root));
+        }
+    }
+
+    // takes over the keys of other, whose handles now refer to this heap, along with the pools they live in.
+    // the root lists are joined and consolidated, O(log n) when both heaps are consolidated and amortised O(log n) otherwise
+    void meld(binomial_heap &&other) {
+        if(this == &other) return;
+
+        nodes.absorb(std::move(other.nodes));
+        items.absorb(std::move(other.items));
+
+        for(binomial_heap_node *root = other.roots, *next; root; root = next) {
+            next = root->next;
+            add_root(root);
+        }
+
+        num_items += std::exchange(other.num_items, 0);
+        other.roots = other.the_target = nullptr;
+
+        clean();
+    }
+
+    // links roots of equal rank until every rank has at most one root, and picks the target among them.
+    // a tree of rank r holds 2^r keys, so ranks fit in a fixed scratch array
     void clean() {
-        std::vector<node_t> forest;
+        std::array<binomial_heap_node*, sizeof(size_t) * 8> forest{};
+        size_t num_ranks = 0;
 
-        for(node_t current; current || !the_binomial_tree.empty();) {
-            if(!current) {
-                current = std::move(the_binomial_tree.back());
-                the_binomial_tree.pop_back();
-            }
+        for(binomial_heap_node *current = roots, *next; current; current = next) {
+            next = current->next;
 
-            while(forest.size() <= current->rank) forest.emplace_back();
-            if(forest.at(current->rank)) {
-                node_t other = std::move(forest.at(current->rank));
-                current = merge(std::move(current), std::move(other));
-            }
-            else {
-                forest[current->rank] = std::move(current);
+            while(forest[current->rank]) {
+                binomial_heap_node *other = std::exchange(forest[current->rank], nullptr);
+                current = merge(current, other);
             }
+
+            forest[current->rank] = current;
+            num_ranks = std::max(num_ranks, current->rank + 1);
         }
 
-        for(size_t k=forest.size(); k>0; --k) {
-            if(forest.at(k-1)) {
-                the_binomial_tree.emplace_back(std::move(forest.at(k-1)));
+        roots = nullptr;
+        the_target = nullptr;
+        for(size_t k=num_ranks; k>0; --k) {
+            if(forest[k-1]) {
+                add_root(forest[k-1]);
+                offer_target(forest[k-1]);
             }
         }
     }
 
-    void delete_max_or_min() {
-        if(the_binomial_tree.empty()) return;
+    // hands back the deleted key
+    std::optional<T> delete_max_or_min() {
+        if(!the_target) return {};
+
+        binomial_heap_item *item = remove_root(the_target);
+        std::optional<T> key{std::move(item->key)};
+        items.release(item);
+
+        clean();
+
+        return key;
+    }
 
-        auto target_it = get_target_it(); 
-        for(size_t k=0; k<target_it->children.size(); ++k) {
-            the_binomial_tree.emplace_back(std::move(target_it->children.at(k)));
+    // moves the best min(k, size()) keys to out in order and hands back the end of what was written.
+    // the candidates for the next key are the roots and the children of keys already taken, they are
+    // kept in a binary heap of their own and the forest is consolidated once at the end, O(k log n)
+    template<typename OutputIt> OutputIt pop_k(size_t k, OutputIt out) {
+        using candidate = typename decltype(candidates)::value_type;
+        const auto loses = [this](const candidate &a, const candidate &b) { return comp(*b.first, *a.first); };
+
+        candidates.clear();
+        for(binomial_heap_node *root = roots; root; root = root->next) candidates.emplace_back(&root->key(), root);
+        std::make_heap(candidates.begin(), candidates.end(), loses);
+
+        for(k = std::min(k, num_items); k > 0; --k) {
+            std::pop_heap(candidates.begin(), candidates.end(), loses);
+            binomial_heap_node *best = candidates.back().second;
+            candidates.pop_back();
+
+            for(binomial_heap_node *child = best->child; child; child = child->next) {
+                candidates.emplace_back(&child->key(), child);
+                std::push_heap(candidates.begin(), candidates.end(), loses);
+            }
+
+            *out = std::move(best->item->key);
+            ++out;
+
+            items.release(best->item);
+            nodes.release(best);
+            --num_items;
         }
 
+        // whatever is left as a candidate heads a tree of its own
+        roots = nullptr;
+        for(auto &candidate : candidates) add_root(candidate.second);
+
         clean();
 
-        the_binomial_tree.erase(target_it);
-        if(the_binomial_tree.empty()) the_max_or_min = {};
-        else the_max_or_min = get_target_it()->key;
+        return out;
     }
 
     void print() const {
-        for(auto &it : the_binomial_tree) it->print();
+        for(auto it = roots; it; it = it->next) it->print();
     }
 };
 
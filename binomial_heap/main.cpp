@@ -1,7 +1,405 @@
 #include "binomial_heap.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <new>
+#include <vector>
+
+
+// every allocation made through new is counted, so steady state heap operations can be checked to make none
+size_t num_allocations = 0, num_bytes_allocated = 0;
+
+void *operator new(size_t size) {
+    ++num_allocations;
+    num_bytes_allocated += size;
+
+    if(void *p = std::malloc(size)) return p;
+    else throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// a heap of size keys, then rounds of popping the top, pushing a bigger key and either lowering it or erasing
+// and pushing it again. returns the allocations made by the rounds after the first, which warms the heap up
+size_t steady_state_allocations(binomial_heap<uint64_t> &heap, size_t size, size_t num_rounds) {
+    std::mt19937_64 gen{size};
+
+    for(size_t k=0; k<size; ++k) heap.insert(gen() % (size << 4));
+
+    size_t before = 0;
+    for(size_t round=0; round<=num_rounds; ++round) {
+        if(round == 1) before = num_allocations;
+
+        const uint64_t top = *heap.delete_max_or_min();
+        auto h = heap.insert(top + gen() % (size << 4));
+
+        if(round % 2) {
+            heap.decrease_key(h, h.key() - h.key() / 4);
+        }
+        else {
+            heap.erase(h);
+            heap.insert(top + gen() % (size << 4));
+        }
+    }
+
+    return num_allocations - before;
+}
+
+void check_against_multiset(size_t num_ops) {
+    using keyed = std::pair<int, size_t>;
+
+    binomial_heap<keyed> heap;
+    std::multiset<keyed> expected;
+    std::vector<binomial_heap<keyed>::handle> handles;
+    std::vector<size_t> live, where;
+
+    std::mt19937 gen{42};
+
+    auto drop = [&](size_t id) {
+        live[where[id]] = live.back();
+        where[live.back()] = where[id];
+        live.pop_back();
+    };
+
+    for(size_t k=0; k<num_ops; ++k) {
+        const auto op = gen() % 8;
+
+        if(op < 3 || expected.empty()) {
+            const keyed key{static_cast<int>(gen() % 1000), handles.size()};
+            where.push_back(live.size());
+            live.push_back(key.second);
+            handles.push_back(heap.insert(key));
+            expected.insert(key);
+        }
+        else if(op < 5) {
+            const auto deleted = heap.delete_max_or_min();
+            assert(deleted && *deleted == *expected.begin());
+            expected.erase(expected.begin());
+            drop(deleted->second);
+        }
+        else if(op < 7) {
+            const size_t id = live[gen() % live.size()];
+            const keyed old_key = handles[id].key();
+            const keyed new_key{old_key.first - static_cast<int>(gen() % 100), id};
+
+            heap.decrease_key(handles[id], new_key);
+            expected.erase(old_key);
+            expected.insert(new_key);
+        }
+        else {
+            const size_t id = live[gen() % live.size()];
+            expected.erase(handles[id].key());
+            heap.erase(handles[id]);
+            drop(id);
+        }
+
+        assert(heap.size() == expected.size());
+        assert(expected.empty() ? !heap.max_or_min() : heap.max_or_min() == *expected.begin());
+    }
+
+    while(!expected.empty()) {
+        assert(heap.delete_max_or_min() == *expected.begin());
+        expected.erase(expected.begin());
+    }
+    assert(heap.empty() && !heap.delete_max_or_min());
+}
+
+// heaps built apart and melded keep every key in order, and the handles of every part
+void check_meld(size_t num_parts, size_t part_size) {
+    std::vector<binomial_heap<int>> parts(num_parts);
+    std::vector<std::vector<binomial_heap<int>::handle>> handles(num_parts);
+    std::multiset<int> expected;
+
+    std::mt19937 gen{7};
+    for(size_t part=0; part<num_parts; ++part) {
+        for(size_t k=0; k<part_size; ++k) {
+            const int key = static_cast<int>(gen() % 100000);
+            handles[part].push_back(parts[part].insert(key));
+            expected.insert(key);
+        }
+
+        // a consolidated part and a part of single roots
+        if(part % 2) parts[part].clean();
+    }
+
+    binomial_heap<int> heap;
+    std::optional<int> best;
+    for(auto &part : parts) {
+        best = std::min(best.value_or(*part.max_or_min()), *part.max_or_min());
+
+        heap.meld(std::move(part));
+        assert(part.empty() && !part.max_or_min());
+        assert(heap.max_or_min() == best);
+    }
+    assert(heap.size() == expected.size());
+
+    // lowering one key of every part through its old handle
+    for(size_t part=0; part<num_parts; ++part) {
+        const int old_key = handles[part].back().key();
+        heap.decrease_key(handles[part].back(), old_key - 200000);
+        expected.erase(expected.find(old_key));
+        expected.insert(old_key - 200000);
+        assert(heap.max_or_min() == *expected.begin());
+    }
+
+    while(!expected.empty()) {
+        assert(heap.delete_max_or_min() == *expected.begin());
+        expected.erase(expected.begin());
+    }
+    assert(heap.empty());
+}
+
+// build and pop_k agree with sorting, whether the heap already holds keys and handles or not
+void check_build_and_pop_k(size_t num_keys) {
+    std::mt19937 gen{11};
+    std::vector<int> keys(num_keys);
+    for(auto &key : keys) key = static_cast<int>(gen() % 100000);
+
+    binomial_heap<int> heap;
+    heap.build(keys.begin(), keys.end());
+    assert(heap.size() == num_keys);
+    assert(heap.max_or_min() == *std::min_element(keys.begin(), keys.end()));
+
+    // a handle from before a build and a pop_k still works
+    const auto h = heap.insert(50000);
+    keys.push_back(-1);
+
+    std::vector<int> more(num_keys / 2);
+    for(auto &key : more) key = static_cast<int>(gen() % 100000);
+    heap.build(more.begin(), more.end());
+    keys.insert(keys.end(), more.begin(), more.end());
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> popped;
+    heap.pop_k(10, std::back_inserter(popped));
+    heap.decrease_key(h, -1);
+    heap.pop_k(num_keys / 3, std::back_inserter(popped));
+    assert(heap.size() == keys.size() - popped.size());
+
+    for(size_t k=0; k<num_keys/3; ++k) {
+        assert(heap.delete_max_or_min() == keys[popped.size()]);
+        popped.push_back(keys[popped.size()]);
+    }
+
+    // asking for more than is there takes everything
+    heap.pop_k(keys.size(), std::back_inserter(popped));
+    assert(popped.size() == keys.size() && heap.empty());
+    assert(std::equal(popped.begin(), popped.begin() + 10, keys.begin() + 1));
+    assert(popped[10] == -1);
+    assert(std::equal(popped.begin() + 11, popped.end(), keys.begin() + 11));
+
+    // a single pass input range
+    std::istringstream stream{"5 3 9 1 7"};
+    heap.build(std::istream_iterator<int>{stream}, std::istream_iterator<int>{});
+    std::vector<int> all(5);
+    assert(heap.pop_k(5, all.begin()) == all.end());
+    assert((all == std::vector<int>{1, 3, 5, 7, 9}));
+}
+
+// a producer heap reused for round after round of meld, the memory taken must follow the keys melded
+// and not the number of rounds. melding and move assigning a heap into itself leaves it alone
+void check_repeated_meld(size_t num_rounds) {
+    binomial_heap<int> global, local;
+
+    const size_t before = num_bytes_allocated;
+    for(size_t round=0; round<num_rounds; ++round) {
+        local.insert(static_cast<int>(round));
+        global.meld(std::move(local));
+    }
+    assert(global.size() == num_rounds && local.empty());
+
+    // one slab of 64 slots per pool and round, the donor must not pass its growth on
+    assert(num_bytes_allocated - before < num_rounds * 64 * 128);
+
+    binomial_heap<int> &same = global;
+    global.meld(std::move(same));
+    global = std::move(same);
+    assert(global.size() == num_rounds && global.max_or_min() == 0);
+
+    for(size_t k=0; k<num_rounds; ++k) assert(global.delete_max_or_min() == static_cast<int>(k));
+}
+
+struct graph {
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> edges;
+};
+
+graph random_graph(uint32_t num_vertices, size_t num_edges) {
+    graph g{std::vector<std::vector<std::pair<uint32_t, uint32_t>>>(num_vertices)};
+
+    std::mt19937 gen{num_vertices};
+    for(uint32_t v=1; v<num_vertices; ++v) g.edges[gen() % v].emplace_back(v, gen() % 1000 + 1);
+    for(size_t k=num_vertices; k<num_edges; ++k) g.edges[gen() % num_vertices].emplace_back(gen() % num_vertices, gen() % 1000 + 1);
+
+    return g;
+}
+
+using entry = std::pair<uint64_t, uint32_t>;
+constexpr uint64_t unreached = std::numeric_limits<uint64_t>::max();
+
+// one entry per vertex, improving a distance decreases its key in place
+std::vector<uint64_t> dijkstra_with_handles(const graph &g, size_t &peak) {
+    std::vector<uint64_t> distance(g.edges.size(), unreached);
+    std::vector<binomial_heap<entry>::handle> handles(g.edges.size());
+    std::vector<bool> queued(g.edges.size());
+    binomial_heap<entry> heap;
+
+    distance[0] = 0;
+    handles[0] = heap.insert(entry{0, 0});
+    queued[0] = true;
+    peak = 1;
+
+    while(auto top = heap.delete_max_or_min()) {
+        const auto [d, u] = *top;
+        queued[u] = false;
+
+        for(auto [v, w] : g.edges[u]) {
+            if(d + w >= distance[v]) continue;
+
+            distance[v] = d + w;
+            if(queued[v]) {
+                heap.decrease_key(handles[v], entry{d + w, v});
+            }
+            else {
+                handles[v] = heap.insert(entry{d + w, v});
+                queued[v] = true;
+            }
+        }
+
+        peak = std::max(peak, heap.size());
+    }
+
+    return distance;
+}
+
+// every improvement pushes another entry, stale ones are skipped when they come out
+std::vector<uint64_t> dijkstra_lazy(const graph &g, size_t &peak) {
+    std::vector<uint64_t> distance(g.edges.size(), unreached);
+    binomial_heap<entry> heap;
+
+    distance[0] = 0;
+    heap.insert(entry{0, 0});
+    peak = 1;
+
+    while(auto top = heap.delete_max_or_min()) {
+        const auto [d, u] = *top;
+        if(d > distance[u]) continue;
+
+        for(auto [v, w] : g.edges[u]) {
+            if(d + w >= distance[v]) continue;
+
+            distance[v] = d + w;
+            heap.insert(entry{d + w, v});
+        }
+
+        peak = std::max(peak, heap.size());
+    }
+
+    return distance;
+}
+
+void benchmark_dijkstra(uint32_t num_vertices, size_t num_edges) {
+    const graph g = random_graph(num_vertices, num_edges);
+
+    size_t handles_peak, lazy_peak;
+
+    auto start = std::chrono::steady_clock::now();
+    const auto with_handles = dijkstra_with_handles(g, handles_peak);
+    const double handles_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    const auto lazy = dijkstra_lazy(g, lazy_peak);
+    const double lazy_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    assert(with_handles == lazy);
+
+    std::cout << num_vertices << " vertices, " << num_edges << " edges"
+        << ": handles " << handles_seconds << " s, peak " << handles_peak
+        << "; lazy deletion " << lazy_seconds << " s, peak " << lazy_peak << std::endl;
+}
+
+void benchmark_steady_state(size_t size, size_t num_rounds) {
+    binomial_heap<uint64_t> heap;
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t allocations = steady_state_allocations(heap, size, num_rounds);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << size << " keys, " << num_rounds << " rounds: " << seconds << " s, "
+        << static_cast<double>(allocations) / num_rounds << " allocations per round" << std::endl;
+}
+
+void benchmark_top_k(size_t num_keys, size_t k) {
+    std::mt19937_64 gen{num_keys};
+    std::vector<uint64_t> keys(num_keys);
+    for(auto &key : keys) key = gen();
+
+    std::vector<uint64_t> one_by_one, bulk;
+    one_by_one.reserve(k);
+    bulk.reserve(k);
+
+    double insert_seconds, delete_seconds, build_seconds, pop_k_seconds;
+
+    {
+        binomial_heap<uint64_t> heap;
+
+        auto start = std::chrono::steady_clock::now();
+        for(auto key : keys) heap.insert(key);
+        heap.clean();
+        insert_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for(size_t j=0; j<k; ++j) one_by_one.push_back(*heap.delete_max_or_min());
+        delete_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    {
+        binomial_heap<uint64_t> heap;
+
+        auto start = std::chrono::steady_clock::now();
+        heap.build(keys.begin(), keys.end());
+        build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        heap.pop_k(k, std::back_inserter(bulk));
+        pop_k_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    assert(one_by_one == bulk);
+
+    std::cout << num_keys << " keys, top " << k
+        << ": inserts and clean " << insert_seconds << " s, deletes " << delete_seconds
+        << " s; build " << build_seconds << " s, pop_k " << pop_k_seconds << " s" << std::endl;
+}
+
+void benchmark() {
+    benchmark_top_k(1000000, 1000);
+    benchmark_top_k(10000000, 1000);
+    benchmark_top_k(10000000, 100000);
+    benchmark_steady_state(1000, 10000000);
+    benchmark_steady_state(1000000, 3000000);
+    benchmark_dijkstra(100000, 1000000);
+    benchmark_dijkstra(1000000, 10000000);
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark();
+        return 0;
+    }
 
-int main() {
     binomial_heap<int> the_heap;
 
     the_heap.insert(5);
@@ -30,4 +428,27 @@ int main() {
     std::cout << std::endl;
     the_heap.clean();
     the_heap.print();
+
+    check_against_multiset(100000);
+    check_meld(8, 1000);
+    check_repeated_meld(1000);
+    check_build_and_pop_k(100000);
+
+    // keys that own memory are destroyed with the heap, moved over or not
+    {
+        binomial_heap<std::string> words, more;
+        for(int k=0; k<100; ++k) words.insert(std::string(32, static_cast<char>('a' + k % 26)));
+        for(int k=0; k<10; ++k) more.insert(std::string(32, 'z'));
+
+        assert(words.delete_max_or_min() == std::string(32, 'a'));
+        words = std::move(more);
+        assert(words.size() == 10 && more.empty());
+    }
+
+    binomial_heap<uint64_t> warm;
+    assert(steady_state_allocations(warm, 1000, 100000) == 0);
+
+    size_t peak;
+    const graph g = random_graph(2000, 20000);
+    assert(dijkstra_with_handles(g, peak) == dijkstra_lazy(g, peak));
 }
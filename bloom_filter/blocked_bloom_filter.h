@@ -0,0 +1,105 @@
+#ifndef BLOCKED_BLOOM_FILTER_H
+#define BLOCKED_BLOOM_FILTER_H
+
+#include "bloom_filter.h"
+
+#include <array>
+#include <cstdint>
+
+
+// all the bits of a key sit in one cache line sized block, so a query costs a single miss.
+// h1 picks the block and h2 sets one bit in each of its 8 words, 8 hash functions in total
+template<
+    typename T,
+    HashFunc<T> h1,
+    HashFunc<T> h2 = nullptr,
+    size_t num_blocks = 1 << 10
+> class blocked_bloom_filter {
+    static constexpr size_t words_per_block = 8;
+
+    struct alignas(64) block {
+        std::array<uint64_t, words_per_block> words;
+    };
+
+    std::array<block, num_blocks> the_blocks;
+
+    // multiplying by a different odd salt per word and keeping the top 6 bits gives
+    // each word its own bit, without any data dependent loop
+    static block pattern_of(size_t hash) {
+        static constexpr std::array<uint64_t, words_per_block> salts{
+            0x47b6137b44974d91, 0x8824ad5ba2b7289d, 0x705495c72df1424b, 0x9efc49475c6bfb31,
+            0xa2b7289d8824ad5b, 0x2df1424b705495c7, 0x5c6bfb319efc4947, 0x44974d9147b6137b
+        };
+
+        block pattern;
+        for(size_t k=0; k<words_per_block; ++k) {
+            pattern.words[k] = uint64_t(1) << ((hash * salts[k]) >> 58);
+        }
+
+        return pattern;
+    }
+
+    static constexpr size_t batch_size = 16;
+
+    template<bool for_write, typename It, typename Func> void for_each_batched(It first, It last, Func &&fn) const {
+        std::array<size_t, batch_size> indices;
+        std::array<block, batch_size> patterns;
+
+        while(first != last) {
+            size_t num_keys = 0;
+            for(; num_keys < batch_size && first != last; ++num_keys, ++first) {
+                const wide_hash hash = wide_hash_of<T, h1, h2>(*first);
+
+                indices[num_keys] = hash.first % num_blocks;
+                prefetch<for_write>(&the_blocks[indices[num_keys]]);
+                patterns[num_keys] = pattern_of(hash.second);
+            }
+
+            for(size_t n=0; n<num_keys; ++n) fn(indices[n], patterns[n]);
+        }
+    }
+
+    public:
+    blocked_bloom_filter():
+        the_blocks{}
+    {}
+
+    void insert(const T& key) {
+        const wide_hash hash = wide_hash_of<T, h1, h2>(key);
+        block &the_block = the_blocks[hash.first % num_blocks];
+        const block pattern = pattern_of(hash.second);
+
+        for(size_t k=0; k<words_per_block; ++k) the_block.words[k] |= pattern.words[k];
+    }
+
+    // tests every word of the block at once instead of bailing out bit by bit, which vectorizes
+    bool contains(const T& key) const {
+        const wide_hash hash = wide_hash_of<T, h1, h2>(key);
+        const block &the_block = the_blocks[hash.first % num_blocks];
+        const block pattern = pattern_of(hash.second);
+
+        uint64_t missing = 0;
+        for(size_t k=0; k<words_per_block; ++k) missing |= pattern.words[k] & ~the_block.words[k];
+
+        return missing == 0;
+    }
+
+    template<typename It> void insert_batch(It first, It last) {
+        for_each_batched<true>(first, last, [this](size_t index, const block &pattern) {
+            for(size_t k=0; k<words_per_block; ++k) the_blocks[index].words[k] |= pattern.words[k];
+        });
+    }
+
+    // writes one bool per key to out, a std::vector<bool> iterator makes that a bitmap
+    template<typename It, typename Out> void contains_batch(It first, It last, Out out) const {
+        for_each_batched<false>(first, last, [this, &out](size_t index, const block &pattern) {
+            uint64_t missing = 0;
+            for(size_t k=0; k<words_per_block; ++k) missing |= pattern.words[k] & ~the_blocks[index].words[k];
+
+            *out = missing == 0;
+            ++out;
+        });
+    }
+};
+
+#endif
@@ -1,24 +1,72 @@
 #ifndef BLOOM_FILTER_H
 #define BLOOM_FILTER_H
 
+#include "hashers.h"
+
+#include <array>
+#include <cstdint>
 #include <functional>
-#include <bitset>
 #include <limits>
 
 
-template<typename T> using HashFunc = size_t(const T&);
+// hints the cache line holding address into the cache ahead of the access
+template<bool for_write=false> inline void prefetch(const void *address) {
+    __builtin_prefetch(address, for_write ? 1 : 0);
+}
 
 template<
     typename T,
     HashFunc<T> h1,
-    HashFunc<T> h2,
+    HashFunc<T> h2 = nullptr,
     size_t num_filters = 16,
-    size_t filter_size = std::numeric_limits<int16_t>::max()
+    size_t filter_size = size_t(1) << 15
 > class bloom_filter {
-    std::array<std::bitset<filter_size>, num_filters> the_filters;
+    static constexpr size_t words_per_filter = (filter_size + 63) / 64;
+    static constexpr bool power_of_two = (filter_size & (filter_size - 1)) == 0;
+
+    // plain words rather than std::bitset, so the batched calls can prefetch them
+    std::array<std::array<uint64_t, words_per_filter>, num_filters> the_filters;
+
+    static size_t position_of(size_t hash) {
+        if constexpr(power_of_two) return hash & (filter_size - 1);
+        else return reduce(hash, filter_size);
+    }
+
+    using positions_t = std::array<size_t, num_filters>;
+
+    // the key is hashed once, every filter takes the next probe of the sequence
+    positions_t positions_of(const T& key) const {
+        probe_sequence probes{wide_hash_of<T, h1, h2>(key)};
+
+        positions_t positions;
+        for(size_t k=0; k<num_filters; ++k) positions[k] = position_of(probes.next());
+
+        return positions;
+    }
+
+    // keys are hashed and their words prefetched a batch at a time, so the cache misses overlap
+    static constexpr size_t batch_size = 16;
+
+    template<bool for_write, typename It, typename Func> void for_each_batched(It first, It last, Func &&fn) const {
+        std::array<positions_t, batch_size> batch;
+
+        while(first != last) {
+            size_t num_keys = 0;
+            for(; num_keys < batch_size && first != last; ++num_keys, ++first) {
+                batch[num_keys] = positions_of(*first);
+                for(size_t k=0; k<num_filters; ++k) prefetch<for_write>(&the_filters[k][batch[num_keys][k] / 64]);
+            }
 
-    size_t multiplicative_hash(const T& key, size_t func_num) const {
-        return (h1(key) + func_num*h2(key)) % filter_size;
+            for(size_t n=0; n<num_keys; ++n) fn(batch[n]);
+        }
+    }
+
+    void set(size_t func_num, size_t position) {
+        the_filters[func_num][position / 64] |= uint64_t(1) << (position % 64);
+    }
+
+    bool test(size_t func_num, size_t position) const {
+        return the_filters[func_num][position / 64] >> (position % 64) & 1;
     }
 
     public:
@@ -27,18 +75,39 @@ template<
     {}
 
     void insert(const T& key) {
+        probe_sequence probes{wide_hash_of<T, h1, h2>(key)};
+
         for(size_t k=0; k<num_filters; ++k) {
-            the_filters.at(k).set(multiplicative_hash(key, k));
+            set(k, position_of(probes.next()));
         }
     }
 
     bool contains(const T& key) const {
+        probe_sequence probes{wide_hash_of<T, h1, h2>(key)};
+
         for(size_t k=0; k<num_filters; ++k) {
-            if(!the_filters.at(k).test(multiplicative_hash(key, k))) return false;
+            if(!test(k, position_of(probes.next()))) return false;
         }
 
         return true;
     }
+
+    template<typename It> void insert_batch(It first, It last) {
+        for_each_batched<true>(first, last, [this](const positions_t &positions) {
+            for(size_t k=0; k<num_filters; ++k) set(k, positions[k]);
+        });
+    }
+
+    // writes one bool per key to out, a std::vector<bool> iterator makes that a bitmap
+    template<typename It, typename Out> void contains_batch(It first, It last, Out out) const {
+        for_each_batched<false>(first, last, [this, &out](const positions_t &positions) {
+            bool found = true;
+            for(size_t k=0; k<num_filters; ++k) found &= test(k, positions[k]);
+
+            *out = found;
+            ++out;
+        });
+    }
 };
 
 #endif
@@ -0,0 +1,136 @@
+#ifndef CONCURRENT_BLOOM_FILTER_H
+#define CONCURRENT_BLOOM_FILTER_H
+
+#include "bloom_filter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+
+// one filter shared by every producer. bits only ever go from 0 to 1, so relaxed fetch_or is enough for
+// inserts and lookups are plain relaxed loads, wait free. a key is guaranteed to be seen by contains once
+// its insert happens before the lookup, e.g. through a thread join or the caller's own synchronization.
+// sharded confines every key to a single cache line, so an insert dirties one line instead of k. lines that
+// draw more than their share of keys then fill up faster, so sharded filters take extra lines to meet target_fpp
+template<
+    typename T,
+    HashFunc<T> h1,
+    HashFunc<T> h2 = nullptr,
+    bool sharded = false
+> class concurrent_bloom_filter {
+    static constexpr size_t words_per_shard = 8;
+    static constexpr size_t bits_per_shard = 64 * words_per_shard;
+
+    struct alignas(64) shard {
+        std::atomic<uint64_t> words[words_per_shard];
+    };
+
+    std::vector<shard> shards;
+    size_t num_bits, num_hashes;
+
+    std::atomic<uint64_t> &word_at(size_t bit) {
+        return shards[bit / bits_per_shard].words[bit % bits_per_shard / 64];
+    }
+
+    const std::atomic<uint64_t> &word_at(size_t bit) const {
+        return shards[bit / bits_per_shard].words[bit % bits_per_shard / 64];
+    }
+
+    template<typename Func> void for_each_bit(const T& key, Func &&fn) const {
+        const wide_hash hash = wide_hash_of<T, h1, h2>(key);
+
+        if constexpr(sharded) {
+            // first picks the shard and the bits inside it come from second alone, so they do not follow the
+            // shard index. each bit is the top of a step of a 64 bit lcg, an additive probe sequence has too
+            // little entropy in its top bits and keys sharing a shard would repeat each other's patterns
+            const size_t base = reduce(hash.first, shards.size()) * bits_per_shard;
+            uint64_t state = hash.second;
+
+            for(size_t k=0; k<num_hashes; ++k) {
+                state = state * 0xd1342543de82ef95 + 1;
+                if(!fn(base + reduce(state, bits_per_shard))) return;
+            }
+        }
+        else {
+            probe_sequence probes{hash};
+
+            for(size_t k=0; k<num_hashes; ++k) {
+                if(!fn(reduce(probes.next(), num_bits))) return;
+            }
+        }
+    }
+
+    // the false positive probability when every key's probes fall in one shard. the number of keys per shard
+    // is Poisson, and the crowded shards are the ones that push the rate over the flat formula
+    static double sharded_fpp(size_t num_shards, size_t n, size_t num_hashes) {
+        const double keys_per_shard = static_cast<double>(n) / num_shards;
+        const double spread = 10 * std::sqrt(keys_per_shard) + 10;
+        const size_t first = keys_per_shard > spread ? static_cast<size_t>(keys_per_shard - spread) : 0;
+        const size_t last = static_cast<size_t>(keys_per_shard + spread);
+
+        double fpp = 0;
+        for(size_t i=first; i<=last; ++i) {
+            const double probability = std::exp(i * std::log(keys_per_shard) - keys_per_shard - std::lgamma(i + 1.0));
+            const double fill = 1 - std::pow(1 - 1.0 / bits_per_shard, static_cast<double>(num_hashes * i));
+
+            fpp += probability * std::pow(fill, static_cast<double>(num_hashes));
+        }
+
+        return fpp;
+    }
+
+    public:
+    // assumes 0 < target_fpp < 1. a sharded filter is grown past the flat size until sharded_fpp meets
+    // the target, about 5% more bits at 1% and 10% more at 0.1%, and at most 4 times the flat size
+    concurrent_bloom_filter(size_t expected_n, double target_fpp):
+        shards{},
+        num_bits{},
+        num_hashes{}
+    {
+        const bloom_shape shape = bloom_shape_for(expected_n, target_fpp, bits_per_shard);
+
+        size_t num_shards = shape.num_cells / bits_per_shard;
+        num_hashes = shape.num_hashes;
+
+        if constexpr(sharded) {
+            const size_t n = std::max<size_t>(expected_n, 1);
+
+            while(num_shards < 4 * shape.num_cells / bits_per_shard && sharded_fpp(num_shards, n, num_hashes) > target_fpp) {
+                num_shards += std::max<size_t>(1, num_shards / 64);
+                num_hashes = std::max<size_t>(1, static_cast<size_t>(std::round(num_shards * bits_per_shard * std::log(2.0) / n)));
+            }
+        }
+
+        shards = std::vector<shard>(num_shards);
+        num_bits = num_shards * bits_per_shard;
+    }
+
+    void insert(const T& key) {
+        for_each_bit(key, [this](size_t bit) {
+            std::atomic<uint64_t> &word = word_at(bit);
+            const uint64_t mask = uint64_t(1) << (bit % 64);
+
+            // reading first keeps bits that are already set from bouncing the line between writers
+            if(!(word.load(std::memory_order_relaxed) & mask)) word.fetch_or(mask, std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    bool contains(const T& key) const {
+        bool found = true;
+
+        for_each_bit(key, [this, &found](size_t bit) {
+            found = word_at(bit).load(std::memory_order_relaxed) >> (bit % 64) & 1;
+            return found;
+        });
+
+        return found;
+    }
+
+    size_t bit_count() const { return num_bits; }
+    size_t hash_count() const { return num_hashes; }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef HASHERS_H
+#define HASHERS_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+template<typename T> using HashFunc = size_t(const T&);
+
+namespace hashing {
+    constexpr uint64_t secret0 = 0xa0761d6478bd642f;
+    constexpr uint64_t secret1 = 0xe7037ed1a0b428db;
+    constexpr uint64_t secret2 = 0x8ebc6af09c88c6e3;
+
+    // folds the full 128 bit product, every input bit reaches every output bit
+    inline uint64_t mum(uint64_t a, uint64_t b) {
+        const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+    }
+
+    inline uint64_t read64(const unsigned char *bytes) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    inline uint64_t read32(const unsigned char *bytes) {
+        uint32_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+}
+
+// 16 bytes per multiply, the tail is read as two overlapping words instead of byte by byte
+inline size_t hash_bytes(const void *data, size_t size, uint64_t seed = 0) {
+    using namespace hashing;
+
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    uint64_t state = seed ^ secret0;
+    size_t remaining = size;
+
+    for(; remaining > 16; remaining -= 16, bytes += 16) {
+        state = mum(read64(bytes) ^ secret1, read64(bytes + 8) ^ state);
+    }
+
+    uint64_t a = 0, b = 0;
+    if(remaining >= 8) {
+        a = read64(bytes);
+        b = read64(bytes + remaining - 8);
+    }
+    else if(remaining >= 4) {
+        a = read32(bytes);
+        b = read32(bytes + remaining - 4);
+    }
+    else if(remaining > 0) {
+        a = uint64_t(bytes[0]) << 16 | uint64_t(bytes[remaining / 2]) << 8 | bytes[remaining - 1];
+    }
+
+    return mum(secret1 ^ size, mum(a ^ secret1, b ^ state));
+}
+
+// a view of raw bytes, for keys that are neither integers nor strings
+struct byte_span {
+    const void *data;
+    size_t size;
+};
+
+// built in hashers, each fits the HashFunc slot of every filter: bloom_filter<std::string, fast_hash>
+template<typename T> std::enable_if_t<std::is_integral_v<T>, size_t> fast_hash(const T &key) {
+    uint64_t x = static_cast<uint64_t>(key) + 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+inline size_t fast_hash(const std::string_view &key) { return hash_bytes(key.data(), key.size()); }
+inline size_t fast_hash(const std::string &key) { return hash_bytes(key.data(), key.size()); }
+inline size_t fast_hash(const byte_span &key) { return hash_bytes(key.data, key.size); }
+
+// the 2x64 bit hash every probe of a key is derived from
+struct wide_hash {
+    size_t first, second;
+};
+
+// without h2 the second half is remixed from the first, so a key is hashed once per operation.
+// assumes h1 spreads its output over all 64 bits when h2 is left out, like the built in hashers
+template<typename T, HashFunc<T> h1, HashFunc<T> h2> inline wide_hash wide_hash_of(const T &key) {
+    const size_t first = h1(key);
+
+    if constexpr(h2 == nullptr) return {first, hashing::mum(first ^ hashing::secret2, hashing::secret1)};
+    else return {first, h2(key)};
+}
+
+// enhanced double hashing, the k-th probe is first + k*second + (k^3 - k)/6. the cubic term keeps
+// probes apart when second is a multiple of a large power of two, and costs two additions per probe
+class probe_sequence {
+    size_t position, stride, num_probes;
+
+    public:
+    probe_sequence(wide_hash hash):
+        position{hash.first},
+        stride{hash.second},
+        num_probes{0}
+    {}
+
+    size_t next() {
+        const size_t current = position;
+        position += stride;
+        stride += ++num_probes;
+
+        return current;
+    }
+};
+
+// maps a full width hash onto [0, n) with a multiply and a shift instead of a division
+inline size_t reduce(size_t hash, size_t n) {
+    return static_cast<size_t>((static_cast<unsigned __int128>(hash) * n) >> 64);
+}
+
+// cells are bits, or counters for a counting filter
+struct bloom_shape {
+    size_t num_cells, num_hashes;
+};
+
+// the cells and hashes that hold expected_n keys at target_fpp, with the cells rounded up to whole units.
+// assumes 0 < target_fpp < 1, anything outside is clamped into range when asserts are off
+inline bloom_shape bloom_shape_for(size_t expected_n, double target_fpp, size_t cells_per_unit) {
+    assert(0 < target_fpp && target_fpp < 1);
+    target_fpp = std::clamp(target_fpp, std::numeric_limits<double>::min(), 1.0);
+
+    const double ln2 = std::log(2.0);
+    const size_t n = std::max<size_t>(expected_n, 1);
+    const double optimal_cells = -static_cast<double>(n) * std::log(target_fpp) / (ln2 * ln2);
+
+    const size_t num_cells = std::max<size_t>(1, static_cast<size_t>(std::ceil(optimal_cells / cells_per_unit))) * cells_per_unit;
+    return {num_cells, std::max<size_t>(1, static_cast<size_t>(std::round(num_cells * ln2 / n)))};
+}
+
+#endif
@@ -1,7 +1,26 @@
 #include "bloom_filter.h"
+#include "blocked_bloom_filter.h"
+#include "concurrent_bloom_filter.h"
+#include "counting_bloom_filter.h"
+#include "runtime_bloom_filter.h"
+#include "scalable_bloom_filter.h"
+#include "xor_filter.h"
 
+#include <bitset>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 std::hash<size_t> the_hasher{};
@@ -9,8 +28,229 @@ std::hash<size_t> the_hasher{};
 size_t identity(const size_t &key) { return key; }
 size_t std_hash(const size_t &key) { return the_hasher(key); }
 
+// splitmix64 finalizers with different seeds, std::hash is the identity on integers
+size_t mix(size_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111eb;
+    return key ^ (key >> 31);
+}
+size_t mix_hash1(const size_t &key) { return mix(key + 0x9e3779b97f4a7c15); }
+size_t mix_hash2(const size_t &key) { return mix(key + 0x632be59bd9b4e019); }
+
+
+std::hash<std::string> the_string_hasher{};
+
+size_t string_hash1(const std::string &key) { return the_string_hasher(key); }
+size_t string_hash2(const std::string &key) { return mix(the_string_hasher(key)); }
+
+std::vector<std::string> make_strings(size_t first, size_t last) {
+    std::vector<std::string> strings;
+    for(size_t k=first; k<last; ++k) strings.push_back("user:" + std::to_string(mix(k)) + "/session");
+
+    return strings;
+}
+
+
+using blocked_filter = blocked_bloom_filter<size_t, mix_hash1, mix_hash2, 1 << 10>;
+
+// whether keys can be added to a filter, a mapped one must not offer insert at all
+template<typename Filter, typename = void> struct can_insert: std::false_type {};
+template<typename Filter> struct can_insert<Filter, std::void_t<decltype(std::declval<Filter&>().insert(size_t{}))>>: std::true_type {};
+
+template<typename Filter> double false_positive_rate(const Filter &filter, size_t first_absent, size_t num_probes) {
+    size_t false_positives = 0;
+    for(size_t k=first_absent; k<first_absent + num_probes; ++k) false_positives += filter.contains(k);
+
+    return static_cast<double>(false_positives) / num_probes;
+}
+
+template<typename Filter> void report(const char *name, size_t num_keys) {
+    constexpr size_t num_probes = 1 << 22;
+
+    auto filter = std::make_unique<Filter>();
+
+    const auto start = std::chrono::steady_clock::now();
+    for(size_t k=0; k<num_keys; ++k) filter->insert(k);
+    const auto inserted = std::chrono::steady_clock::now();
+    const double fpr = false_positive_rate(*filter, num_keys, num_probes);
+    const auto probed = std::chrono::steady_clock::now();
+
+    std::cout << name
+        << ": fpr " << fpr
+        << ", insert " << num_keys / std::chrono::duration<double>(inserted - start).count() / 1e6 << " Mops/s"
+        << ", contains " << num_probes / std::chrono::duration<double>(probed - inserted).count() / 1e6 << " Mops/s" << std::endl;
+}
+
+// both layouts hold the same number of bits and use 8 hash functions
+template<size_t log_bits> void benchmark_layouts() {
+    using classic = bloom_filter<size_t, mix_hash1, mix_hash2, 8, (size_t(1) << log_bits) / 8>;
+    using blocked = blocked_bloom_filter<size_t, mix_hash1, mix_hash2, (size_t(1) << log_bits) / 512>;
+
+    std::cout << "2^" << log_bits << " bits" << std::endl;
+    for(size_t bits_per_key : {8, 12, 16}) {
+        const size_t num_keys = (size_t(1) << log_bits) / bits_per_key;
+        std::cout << bits_per_key << " bits per key, expected classic fpr " << std::pow(1 - std::exp(-8.0 / bits_per_key), 8) << std::endl;
+
+        report<classic>("  classic", num_keys);
+        report<blocked>("  blocked", num_keys);
+    }
+}
+
+template<typename Filter> void benchmark_batched(const char *name, size_t num_keys) {
+    constexpr size_t num_probes = 1 << 22;
+
+    std::vector<size_t> keys(num_keys), probes(num_probes);
+    std::iota(keys.begin(), keys.end(), 0);
+    for(size_t k=0; k<num_probes; ++k) probes[k] = mix(k) % (2 * num_keys);
+    std::vector<bool> found(num_probes);
+
+    auto per_second = [](size_t num_ops, auto start) {
+        return num_ops / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e6;
+    };
+
+    auto single = std::make_unique<Filter>();
+    auto start = std::chrono::steady_clock::now();
+    for(size_t key : keys) single->insert(key);
+    const double single_insert = per_second(num_keys, start);
+
+    start = std::chrono::steady_clock::now();
+    for(size_t k=0; k<num_probes; ++k) found[k] = single->contains(probes[k]);
+    const double single_contains = per_second(num_probes, start);
+
+    auto batched = std::make_unique<Filter>();
+    start = std::chrono::steady_clock::now();
+    batched->insert_batch(keys.begin(), keys.end());
+    const double batched_insert = per_second(num_keys, start);
+
+    start = std::chrono::steady_clock::now();
+    batched->contains_batch(probes.begin(), probes.end(), found.begin());
+    const double batched_contains = per_second(num_probes, start);
+
+    std::cout << name
+        << ": insert " << single_insert << " -> " << batched_insert << " Mops/s"
+        << ", contains " << single_contains << " -> " << batched_contains << " Mops/s" << std::endl;
+}
+
+// the same filter fed by two std::hash calls per key, or by one pass of the built in hasher
+template<typename Filter> void benchmark_strings(const char *name, const std::vector<std::string> &keys, const std::vector<std::string> &probes) {
+    auto filter = std::make_unique<Filter>();
+
+    const auto start = std::chrono::steady_clock::now();
+    for(const auto &key : keys) filter->insert(key);
+    const auto inserted = std::chrono::steady_clock::now();
+
+    size_t found = 0;
+    for(const auto &probe : probes) found += filter->contains(probe);
+    const auto probed = std::chrono::steady_clock::now();
+
+    std::cout << name
+        << ": fpr " << static_cast<double>(found) / probes.size()
+        << ", insert " << keys.size() / std::chrono::duration<double>(inserted - start).count() / 1e6 << " Mops/s"
+        << ", contains " << probes.size() / std::chrono::duration<double>(probed - inserted).count() / 1e6 << " Mops/s" << std::endl;
+}
+
+// filters at about the same false positive rate, built from the same keys
+void benchmark_static(size_t num_keys) {
+    constexpr size_t num_probes = 1 << 22;
+
+    std::vector<size_t> keys(num_keys);
+    for(size_t k=0; k<num_keys; ++k) keys[k] = mix(k);
+
+    auto seconds_since = [](auto start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto report = [&](const char *name, const auto &filter, double build_seconds, size_t num_bytes) {
+        const auto start = std::chrono::steady_clock::now();
+        size_t false_positives = 0;
+        for(size_t k=0; k<num_probes; ++k) false_positives += filter.contains(mix(num_keys + k));
+        const double query_seconds = seconds_since(start);
+
+        std::cout << name
+            << ": fpr " << static_cast<double>(false_positives) / num_probes
+            << ", " << 8.0 * num_bytes / num_keys << " bits per key"
+            << ", build " << num_keys / build_seconds / 1e6 << " Mkeys/s"
+            << ", contains " << num_probes / query_seconds / 1e6 << " Mops/s" << std::endl;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    const xor_filter<size_t, fast_hash> xor8{keys.begin(), keys.end()};
+    report("  xor, 8 bit fingerprints", xor8, seconds_since(start), xor8.memory_usage());
+
+    start = std::chrono::steady_clock::now();
+    const xor_filter<size_t, fast_hash, uint16_t> xor16{keys.begin(), keys.end()};
+    report("  xor, 16 bit fingerprints", xor16, seconds_since(start), xor16.memory_usage());
+
+    start = std::chrono::steady_clock::now();
+    runtime_bloom_filter<size_t, fast_hash> bloom{num_keys, 1.0 / 256};
+    for(size_t key : keys) bloom.insert(key);
+    report("  bloom at 1/256", bloom, seconds_since(start), bloom.bit_count() / 8);
+}
+
+// every thread inserts its own slice of the keys into one shared filter
+template<typename Filter> void benchmark_concurrent(const char *name, size_t num_threads) {
+    constexpr size_t num_keys = 1 << 24;
+
+    Filter filter{num_keys, 0.01};
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(size_t t=0; t<num_threads; ++t) {
+        threads.emplace_back([&filter, t, num_threads]() {
+            for(size_t k=t; k<num_keys; k+=num_threads) filter.insert(mix(k));
+        });
+    }
+    for(auto &thread : threads) thread.join();
+    const auto inserted = std::chrono::steady_clock::now();
+
+    threads.clear();
+    for(size_t t=0; t<num_threads; ++t) {
+        threads.emplace_back([&filter, t, num_threads]() {
+            size_t found = 0;
+            for(size_t k=t; k<num_keys; k+=num_threads) found += filter.contains(mix(k));
+            assert(found == (num_keys - t + num_threads - 1) / num_threads);
+        });
+    }
+    for(auto &thread : threads) thread.join();
+    const auto probed = std::chrono::steady_clock::now();
+
+    std::cout << name << " with " << num_threads << " threads"
+        << ": insert " << num_keys / std::chrono::duration<double>(inserted - start).count() / 1e6 << " Mops/s"
+        << ", contains " << num_keys / std::chrono::duration<double>(probed - inserted).count() / 1e6 << " Mops/s" << std::endl;
+}
+
+void benchmark() {
+    benchmark_layouts<20>();
+    benchmark_layouts<30>();
+
+    // 128MB filters, well past the last level cache
+    std::cout << "single key -> batched, 2^30 bits at 8 bits per key" << std::endl;
+    benchmark_batched<bloom_filter<size_t, mix_hash1, mix_hash2, 8, (size_t(1) << 30) / 8>>("  classic", size_t(1) << 27);
+    benchmark_batched<blocked_bloom_filter<size_t, mix_hash1, mix_hash2, (size_t(1) << 30) / 512>>("  blocked", size_t(1) << 27);
+
+    std::cout << "string keys, 16 hash functions over 2^19 bits" << std::endl;
+    const auto keys = make_strings(0, 1 << 15), probes = make_strings(1 << 15, 1 << 21);
+    benchmark_strings<bloom_filter<std::string, string_hash1, string_hash2>>("  two hashes per key", keys, probes);
+    benchmark_strings<bloom_filter<std::string, fast_hash>>("  one fast_hash per key", keys, probes);
+
+    std::cout << "static filters, 2^24 keys" << std::endl;
+    benchmark_static(size_t(1) << 24);
+
+    std::cout << "shared filter, 2^24 keys at 1%" << std::endl;
+    for(size_t num_threads=1; num_threads<=std::max(1u, std::thread::hardware_concurrency()); num_threads*=2) {
+        benchmark_concurrent<concurrent_bloom_filter<size_t, mix_hash1, mix_hash2>>("  classic", num_threads);
+        benchmark_concurrent<concurrent_bloom_filter<size_t, mix_hash1, mix_hash2, true>>("  sharded", num_threads);
+    }
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark();
+        return 0;
+    }
 
-int main() {
     bloom_filter<size_t, std_hash, identity> filter;
 
     for(size_t k=0; k<0x0000FFFF; ++k) {
@@ -19,4 +259,149 @@ int main() {
         assert(filter.contains(0));
         std::cout << "inserting " << std::bitset<64>(k) << std::endl;
     }
+
+    auto blocked = std::make_unique<blocked_filter>();
+    for(size_t k=0; k<0x0000FFFF; ++k) {
+        blocked->insert(k);
+        assert(blocked->contains(k));
+        assert(blocked->contains(0));
+    }
+    assert(false_positive_rate(*blocked, 0x0000FFFF, 1 << 16) < 0.05);
+
+    // the batched calls agree with the one key at a time ones
+    std::vector<size_t> keys(10000), probes(20000);
+    std::iota(keys.begin(), keys.end(), 1 << 20);
+    std::iota(probes.begin(), probes.end(), 1 << 20);
+
+    auto classic = std::make_unique<bloom_filter<size_t, mix_hash1, mix_hash2>>();
+    classic->insert_batch(keys.begin(), keys.end());
+    blocked->insert_batch(keys.begin(), keys.end());
+
+    std::vector<bool> classic_found(probes.size());
+    std::vector<char> blocked_found(probes.size());
+    classic->contains_batch(probes.begin(), probes.end(), classic_found.begin());
+    blocked->contains_batch(probes.begin(), probes.end(), blocked_found.begin());
+
+    for(size_t k=0; k<probes.size(); ++k) {
+        assert(classic_found[k] == classic->contains(probes[k]));
+        assert(static_cast<bool>(blocked_found[k]) == blocked->contains(probes[k]));
+        if(k < keys.size()) assert(classic_found[k] && blocked_found[k]);
+    }
+
+    // sized for 1% at 10^5 keys, then saved and mapped back in
+    runtime_bloom_filter<size_t, mix_hash1, mix_hash2> sized{100000, 0.01};
+    for(size_t k=0; k<100000; ++k) sized.insert(k);
+    for(size_t k=0; k<100000; ++k) assert(sized.contains(k));
+    assert(false_positive_rate(sized, 100000, 100000) < 0.015);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "runtime_bloom_filter.bin").string();
+    assert(sized.save(path));
+
+    auto mapped = runtime_bloom_filter<size_t, mix_hash1, mix_hash2>::open(path);
+    static_assert(!can_insert<decltype(*mapped)>::value && can_insert<decltype(sized)>::value);
+    assert(mapped);
+    assert(mapped->bit_count() == sized.bit_count() && mapped->hash_count() == sized.hash_count());
+    for(size_t k=0; k<200000; ++k) assert(mapped->contains(k) == sized.contains(k));
+
+    // a header claiming no hashes would report every key, it is refused like a bad magic or size
+    {
+        std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+        const uint32_t no_hashes = 0;
+        file.seekp(12);
+        file.write(reinterpret_cast<const char*>(&no_hashes), sizeof(no_hashes));
+    }
+    assert(!(runtime_bloom_filter<size_t, mix_hash1, mix_hash2>::open(path)));
+    std::remove(path.c_str());
+
+    // no keys or a loose target still get one unit of cells and one hash
+    assert(bloom_shape_for(0, 0.01, 64).num_cells == 64 && bloom_shape_for(1000, 0.5, 64).num_hashes == 1);
+
+    assert(!(runtime_bloom_filter<size_t, mix_hash1, mix_hash2>::open(path)));
+
+    // every filter takes the built in hashers alone, one hash per key
+    auto strings = std::make_unique<bloom_filter<std::string, fast_hash>>();
+    const auto present = make_strings(0, 1000), absent = make_strings(1000, 101000);
+    for(const auto &key : present) strings->insert(key);
+    for(const auto &key : present) assert(strings->contains(key));
+    size_t false_positives = 0;
+    for(const auto &key : absent) false_positives += strings->contains(key);
+    assert(false_positives < 100);
+
+    runtime_bloom_filter<size_t, fast_hash> single_hash{100000, 0.01};
+    for(size_t k=0; k<100000; ++k) single_hash.insert(k);
+    for(size_t k=0; k<100000; ++k) assert(single_hash.contains(k));
+    assert(false_positive_rate(single_hash, 100000, 100000) < 0.015);
+
+    const char bytes[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    for(size_t size=1; size<sizeof(bytes); ++size) {
+        assert(fast_hash(byte_span{bytes, size}) == fast_hash(std::string_view{bytes, size}));
+        assert(fast_hash(byte_span{bytes, size}) != fast_hash(byte_span{bytes, size - 1}));
+    }
+
+    // removing expired keys forgets them, saturated counters keep their keys until a rebuild
+    counting_bloom_filter<size_t, fast_hash> counting{100000, 0.01};
+    for(size_t k=0; k<100000; ++k) counting.insert(k);
+    for(size_t k=0; k<50000; ++k) counting.remove(k);
+    for(size_t k=50000; k<100000; ++k) assert(counting.contains(k));
+    assert(false_positive_rate(counting, 0, 50000) < 0.015);
+    assert(counting.memory_usage() <= 4 * sized.bit_count() / 8 + sizeof(uint64_t));
+
+    counting_bloom_filter<size_t, fast_hash, nullptr, 2> narrow{1000, 0.01};
+    for(size_t round=0; round<4; ++round) {
+        for(size_t k=0; k<1000; ++k) narrow.insert(k);
+    }
+    const size_t saturated = narrow.saturated_count();
+    assert(saturated > 0);
+    for(size_t k=0; k<1000; ++k) narrow.remove(k);
+    for(size_t k=0; k<1000; ++k) assert(narrow.contains(k));
+
+    std::vector<size_t> live(500);
+    std::iota(live.begin(), live.end(), 500);
+    narrow.rebuild(live.begin(), live.end());
+    assert(narrow.saturated_count() < saturated / 10);
+    for(size_t k : live) assert(narrow.contains(k));
+    assert(false_positive_rate(narrow, 0, 500) < 0.05);
+
+    // sized for a thousand keys and fed a million, the false positive rate still holds
+    scalable_bloom_filter<size_t, fast_hash> growing{1000, 0.01};
+    for(size_t k=0; k<1000000; ++k) growing.insert(k);
+    for(size_t k=0; k<1000; ++k) growing.insert(k);
+    for(size_t k=0; k<1000000; ++k) assert(growing.contains(k));
+
+    assert(growing.stage_count() > 5);
+    assert(growing.size() > 985000 && growing.size() <= 1000000);
+    assert(growing.estimated_fpp() < growing.target());
+    assert(false_positive_rate(growing, 1000000, 100000) < growing.target());
+
+    // built once, every key present and 1 in 256 absent ones reported
+    std::vector<size_t> blocklist(100000);
+    std::iota(blocklist.begin(), blocklist.end(), 0);
+    blocklist.push_back(42);
+
+    const xor_filter<size_t, fast_hash> frozen{blocklist.begin(), blocklist.end()};
+    for(size_t key : blocklist) assert(frozen.contains(key));
+    assert(false_positive_rate(frozen, 100000, 1000000) < 0.006);
+    assert(frozen.memory_usage() < 1.24 * 100000 + 64);
+
+    const xor_filter<size_t, fast_hash> nothing{blocklist.end(), blocklist.end()};
+    assert(false_positive_rate(nothing, 0, 1000) < 0.02);
+
+    // four writers racing on one filter lose no keys
+    concurrent_bloom_filter<size_t, mix_hash1, mix_hash2> shared{100000, 0.01};
+    concurrent_bloom_filter<size_t, mix_hash1, mix_hash2, true> sharded{100000, 0.01};
+
+    std::vector<std::thread> writers;
+    for(size_t t=0; t<4; ++t) {
+        writers.emplace_back([&shared, &sharded, t]() {
+            for(size_t k=t; k<100000; k+=4) {
+                shared.insert(k);
+                sharded.insert(k);
+            }
+        });
+    }
+    for(auto &writer : writers) writer.join();
+
+    for(size_t k=0; k<100000; ++k) assert(shared.contains(k) && sharded.contains(k));
+    assert(false_positive_rate(shared, 100000, 100000) < 0.015);
+    assert(false_positive_rate(sharded, 100000, 100000) < 0.0115);
 }
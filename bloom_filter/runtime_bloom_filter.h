@@ -0,0 +1,224 @@
+#ifndef RUNTIME_BLOOM_FILTER_H
+#define RUNTIME_BLOOM_FILTER_H
+
+#include "bloom_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// the bit array shared by runtime_bloom_filter and mapped_bloom_filter, with the lookups and the file format.
+// it only points at words owned by one of them
+template<
+    typename T,
+    HashFunc<T> h1,
+    HashFunc<T> h2 = nullptr
+> class basic_runtime_bloom_filter {
+    protected:
+    // the file is this header followed by the words, in native byte order. 64 bytes keep the words cache aligned
+    struct file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_hashes;
+        uint64_t num_bits;
+        uint64_t reserved[5];
+    };
+    static_assert(sizeof(file_header) == 64);
+
+    static constexpr char magic[8] = {'B', 'L', 'O', 'O', 'M', 'F', 'L', 'T'};
+    static constexpr uint32_t format_version = 2;
+
+    size_t num_bits, num_hashes;
+    const uint64_t *words;
+
+    basic_runtime_bloom_filter(size_t num_bits, size_t num_hashes, const uint64_t *words):
+        num_bits{num_bits},
+        num_hashes{num_hashes},
+        words{words}
+    {}
+
+    public:
+    bool contains(const T& key) const {
+        probe_sequence probes{wide_hash_of<T, h1, h2>(key)};
+
+        for(size_t k=0; k<num_hashes; ++k) {
+            const size_t position = reduce(probes.next(), num_bits);
+            if(!(words[position / 64] >> (position % 64) & 1)) return false;
+        }
+
+        return true;
+    }
+
+    bool save(const std::string &path) const {
+        file_header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = format_version;
+        header.num_hashes = static_cast<uint32_t>(num_hashes);
+        header.num_bits = num_bits;
+
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(words), num_bits / 8);
+
+        return static_cast<bool>(file.flush());
+    }
+
+    size_t bit_count() const { return num_bits; }
+    size_t hash_count() const { return num_hashes; }
+};
+
+// a read only view of a file written by runtime_bloom_filter::save, mapped shared so every process opening it
+// shares the page cache. it has no insert, the mapping cannot be written through
+template<
+    typename T,
+    HashFunc<T> h1,
+    HashFunc<T> h2 = nullptr
+> class mapped_bloom_filter: public basic_runtime_bloom_filter<T, h1, h2> {
+    using base_t = basic_runtime_bloom_filter<T, h1, h2>;
+    using typename base_t::file_header;
+
+    void *mapping;
+    size_t mapping_size;
+
+    mapped_bloom_filter(size_t num_bits, size_t num_hashes, void *mapping, size_t mapping_size):
+        base_t{num_bits, num_hashes, reinterpret_cast<const uint64_t*>(static_cast<const char*>(mapping) + sizeof(file_header))},
+        mapping{mapping},
+        mapping_size{mapping_size}
+    {}
+
+    void release() {
+        if(mapping) munmap(mapping, mapping_size);
+        mapping = nullptr;
+    }
+
+    public:
+    mapped_bloom_filter(const mapped_bloom_filter&) = delete;
+    mapped_bloom_filter &operator=(const mapped_bloom_filter&) = delete;
+
+    mapped_bloom_filter(mapped_bloom_filter &&other):
+        base_t{other.num_bits, other.num_hashes, std::exchange(other.words, nullptr)},
+        mapping{std::exchange(other.mapping, nullptr)},
+        mapping_size{other.mapping_size}
+    {}
+
+    mapped_bloom_filter &operator=(mapped_bloom_filter &&other) {
+        if(this != &other) {
+            release();
+
+            this->num_bits = other.num_bits;
+            this->num_hashes = other.num_hashes;
+            this->words = std::exchange(other.words, nullptr);
+            mapping = std::exchange(other.mapping, nullptr);
+            mapping_size = other.mapping_size;
+        }
+
+        return *this;
+    }
+
+    ~mapped_bloom_filter() { release(); }
+
+    // empty if the file cannot be mapped or is not a filter in this format
+    static std::optional<mapped_bloom_filter> open(const std::string &path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) return {};
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(file_header)) {
+            close(fd);
+            return {};
+        }
+
+        const size_t size = static_cast<size_t>(info.st_size);
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(mapping == MAP_FAILED) return {};
+
+        file_header header;
+        std::memcpy(&header, mapping, sizeof(header));
+
+        if(
+                std::memcmp(header.magic, base_t::magic, sizeof(base_t::magic)) != 0 ||
+                header.version != base_t::format_version ||
+                header.num_hashes == 0 ||
+                header.num_bits == 0 || header.num_bits % 64 != 0 ||
+                size != sizeof(file_header) + header.num_bits / 8
+                ) {
+            munmap(mapping, size);
+            return {};
+        }
+
+        return mapped_bloom_filter{header.num_bits, header.num_hashes, mapping, size};
+    }
+};
+
+// sized at runtime from the expected number of keys and the target false positive probability, the words live on the heap
+template<
+    typename T,
+    HashFunc<T> h1,
+    HashFunc<T> h2 = nullptr
+> class runtime_bloom_filter: public basic_runtime_bloom_filter<T, h1, h2> {
+    using base_t = basic_runtime_bloom_filter<T, h1, h2>;
+
+    std::vector<uint64_t> owned_words;
+
+    public:
+    // assumes 0 < target_fpp < 1
+    runtime_bloom_filter(size_t expected_n, double target_fpp):
+        base_t{0, 0, nullptr},
+        owned_words{}
+    {
+        const bloom_shape shape = bloom_shape_for(expected_n, target_fpp, 64);
+
+        owned_words.resize(shape.num_cells / 64);
+        this->words = owned_words.data();
+        this->num_bits = shape.num_cells;
+        this->num_hashes = shape.num_hashes;
+    }
+
+    runtime_bloom_filter(const runtime_bloom_filter&) = delete;
+    runtime_bloom_filter &operator=(const runtime_bloom_filter&) = delete;
+
+    // moving a vector keeps its buffer, so words stays good
+    runtime_bloom_filter(runtime_bloom_filter &&other):
+        base_t{other.num_bits, other.num_hashes, std::exchange(other.words, nullptr)},
+        owned_words{std::move(other.owned_words)}
+    {}
+
+    runtime_bloom_filter &operator=(runtime_bloom_filter &&other) {
+        if(this != &other) {
+            this->num_bits = other.num_bits;
+            this->num_hashes = other.num_hashes;
+            this->words = std::exchange(other.words, nullptr);
+            owned_words = std::move(other.owned_words);
+        }
+
+        return *this;
+    }
+
+    // maps a file written by save without copying it, the result is read only
+    static std::optional<mapped_bloom_filter<T, h1, h2>> open(const std::string &path) {
+        return mapped_bloom_filter<T, h1, h2>::open(path);
+    }
+
+    void insert(const T& key) {
+        probe_sequence probes{wide_hash_of<T, h1, h2>(key)};
+
+        for(size_t k=0; k<this->num_hashes; ++k) {
+            const size_t position = reduce(probes.next(), this->num_bits);
+            owned_words[position / 64] |= uint64_t(1) << (position % 64);
+        }
+    }
+};
+
+#endif
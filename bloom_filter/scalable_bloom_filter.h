@@ -0,0 +1,100 @@
+#ifndef SCALABLE_BLOOM_FILTER_H
+#define SCALABLE_BLOOM_FILTER_H
+
+#include "runtime_bloom_filter.h"
+
+#include <cmath>
+#include <vector>
+
+
+// a chain of runtime_bloom_filter stages for when the number of keys is not known up front.
+// only the last stage takes inserts, and once it holds its capacity a stage growth times larger
+// is appended. stage i targets target_fpp * (1 - tightening) * tightening^i, so the sum over the
+// whole chain, which bounds the false positive probability, stays under target_fpp however many stages there are
+template<
+    typename T,
+    HashFunc<T> h1,
+    HashFunc<T> h2 = nullptr
+> class scalable_bloom_filter {
+    using stage_t = runtime_bloom_filter<T, h1, h2>;
+
+    struct stage {
+        stage_t filter;
+        size_t capacity, num_keys;
+    };
+
+    std::vector<stage> stages;
+    double target_fpp, growth, tightening;
+    double next_fpp;
+
+    void add_stage(size_t capacity) {
+        stages.push_back(stage{stage_t{capacity, next_fpp}, capacity, 0});
+        next_fpp *= tightening;
+    }
+
+    public:
+    // assumes growth >= 1 and 0 < tightening < 1
+    scalable_bloom_filter(size_t initial_capacity, double target_fpp, double growth=2, double tightening=0.5):
+        stages{},
+        target_fpp{target_fpp},
+        growth{growth},
+        tightening{tightening},
+        next_fpp{target_fpp * (1 - tightening)}
+    {
+        add_stage(std::max<size_t>(initial_capacity, 1));
+    }
+
+    // a key some stage already reports is not inserted again, so duplicates do not use up capacity
+    void insert(const T& key) {
+        if(contains(key)) return;
+
+        if(stages.back().num_keys >= stages.back().capacity) {
+            add_stage(static_cast<size_t>(std::ceil(stages.back().capacity * growth)));
+        }
+
+        stages.back().filter.insert(key);
+        ++stages.back().num_keys;
+    }
+
+    bool contains(const T& key) const {
+        for(auto it=stages.rbegin(); it!=stages.rend(); ++it) {
+            if(it->filter.contains(key)) return true;
+        }
+
+        return false;
+    }
+
+    // the probability that a key never inserted is reported, from the actual fill of every stage
+    double estimated_fpp() const {
+        double all_negative = 1;
+
+        for(const auto &the_stage : stages) {
+            const double k = static_cast<double>(the_stage.filter.hash_count());
+            const double fill = 1 - std::exp(-k * the_stage.num_keys / the_stage.filter.bit_count());
+
+            all_negative *= 1 - std::pow(fill, k);
+        }
+
+        return 1 - all_negative;
+    }
+
+    // distinct keys inserted, short by the keys that were false positives when they arrived, at most about target_fpp of them
+    size_t size() const {
+        size_t num_keys = 0;
+        for(const auto &the_stage : stages) num_keys += the_stage.num_keys;
+
+        return num_keys;
+    }
+
+    size_t stage_count() const { return stages.size(); }
+    double target() const { return target_fpp; }
+
+    size_t bit_count() const {
+        size_t num_bits = 0;
+        for(const auto &the_stage : stages) num_bits += the_stage.filter.bit_count();
+
+        return num_bits;
+    }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef XOR_FILTER_H
+#define XOR_FILTER_H
+
+#include "hashers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+// static membership filter built once from all of its keys. a key is present when the xor of its
+// three fingerprint slots, one in each third of the table, equals its own fingerprint. that takes
+// 3 accesses per lookup and 1.23 * fingerprint bits per key, the false positive probability is 2^-bits.
+// keys are hashed once with h1 and the three slots and the fingerprint are all derived from that
+template<
+    typename T,
+    HashFunc<T> h1,
+    typename Fingerprint = uint8_t
+> class xor_filter {
+    std::vector<Fingerprint> fingerprints;
+    size_t segment_length;
+    uint64_t seed;
+
+    uint64_t reseed(size_t hash) const {
+        return fast_hash(static_cast<uint64_t>(hash) + seed);
+    }
+
+    size_t slot(uint64_t hash, size_t index) const {
+        const uint64_t rotated = index == 0 ? hash : (hash << (21 * index)) | (hash >> (64 - 21 * index));
+        return reduce(rotated, segment_length) + index * segment_length;
+    }
+
+    static Fingerprint fingerprint_of(uint64_t hash) {
+        return static_cast<Fingerprint>(hash ^ (hash >> 32));
+    }
+
+    public:
+    // construction peels the keys off a random 3-hypergraph, and retries with another seed in the rare case
+    // it cannot. keys are deduplicated first, repeated ones would never peel
+    template<typename It> xor_filter(It first, It last):
+        fingerprints{},
+        segment_length{},
+        seed{0x9e3779b97f4a7c15}
+    {
+        std::vector<uint64_t> hashes;
+        for(; first != last; ++first) hashes.push_back(h1(*first));
+
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+        segment_length = std::max<size_t>(1, static_cast<size_t>(std::ceil((1.23 * hashes.size() + 32) / 3)));
+        const size_t num_slots = 3 * segment_length;
+
+        std::vector<uint64_t> xors(num_slots);
+        std::vector<uint32_t> counts(num_slots);
+        std::vector<size_t> singles;
+        std::vector<std::pair<uint64_t, size_t>> peeled;
+
+        while(true) {
+            std::fill(xors.begin(), xors.end(), 0);
+            std::fill(counts.begin(), counts.end(), 0);
+            singles.clear();
+            peeled.clear();
+
+            for(uint64_t hash : hashes) {
+                const uint64_t seeded = reseed(hash);
+
+                for(size_t index=0; index<3; ++index) {
+                    const size_t s = slot(seeded, index);
+                    xors[s] ^= seeded;
+                    ++counts[s];
+                }
+            }
+
+            for(size_t s=0; s<num_slots; ++s) {
+                if(counts[s] == 1) singles.push_back(s);
+            }
+
+            // a slot holding a single key pins that key, removing it can leave its other slots single
+            while(!singles.empty()) {
+                const size_t s = singles.back();
+                singles.pop_back();
+                if(counts[s] != 1) continue;
+
+                const uint64_t seeded = xors[s];
+                peeled.emplace_back(seeded, s);
+
+                for(size_t index=0; index<3; ++index) {
+                    const size_t t = slot(seeded, index);
+                    xors[t] ^= seeded;
+                    if(--counts[t] == 1) singles.push_back(t);
+                }
+            }
+
+            if(peeled.size() == hashes.size()) break;
+            seed = fast_hash(seed);
+        }
+
+        // in reverse peeling order every key still owns its pinned slot, which is set last
+        fingerprints.assign(num_slots, 0);
+        for(auto it=peeled.rbegin(); it!=peeled.rend(); ++it) {
+            const auto [seeded, s] = *it;
+            fingerprints[s] = fingerprint_of(seeded) ^ fingerprints[slot(seeded, 0)] ^ fingerprints[slot(seeded, 1)] ^ fingerprints[slot(seeded, 2)];
+        }
+    }
+
+    bool contains(const T& key) const {
+        const uint64_t seeded = reseed(h1(key));
+
+        return fingerprint_of(seeded) == (fingerprints[slot(seeded, 0)] ^ fingerprints[slot(seeded, 1)] ^ fingerprints[slot(seeded, 2)]);
+    }
+
+    size_t slot_count() const { return fingerprints.size(); }
+    size_t memory_usage() const { return fingerprints.size() * sizeof(Fingerprint); }
+};
+
+#endif
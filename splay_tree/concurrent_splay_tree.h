@@ -0,0 +1,120 @@
+#ifndef CONCURRENT_SPLAY_TREE_H
+#define CONCURRENT_SPLAY_TREE_H
+
+#include "splay_tree.h"
+
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+
+
+enum class splay_action { none, splay, semi_splay };
+
+// every lookup restructures, so every lookup is exclusive
+struct always_splay {
+    static constexpr bool depends_on_depth = false;
+
+    splay_action operator()(size_t) const { return splay_action::splay; }
+};
+
+// splays a random fraction of the lookups, the rest only take the shared lock
+struct probabilistic_splay {
+    static constexpr bool depends_on_depth = false;
+
+    double probability;
+
+    splay_action operator()(size_t) const {
+        static thread_local std::minstd_rand gen{std::random_device{}()};
+        std::bernoulli_distribution coin{probability};
+
+        return coin(gen) ? splay_action::splay : splay_action::none;
+    }
+};
+
+// only keys found deeper than the threshold are brought up
+struct depth_threshold_splay {
+    static constexpr bool depends_on_depth = true;
+
+    size_t threshold;
+
+    splay_action operator()(size_t depth) const {
+        return depth > threshold ? splay_action::splay : splay_action::none;
+    }
+};
+
+// every lookup restructures, but only about half as much as a full splay
+struct always_semi_splay {
+    static constexpr bool depends_on_depth = false;
+
+    splay_action operator()(size_t) const { return splay_action::semi_splay; }
+};
+
+
+// reader/writer wrapper around a bottom up splay_tree. lookups the policy lets off
+// splaying run concurrently under the shared lock, everything else is exclusive
+template<
+    typename K,
+    typename V,
+    typename Comparator=std::less<K>,
+    typename SplayPolicy=always_splay
+> class concurrent_splay_tree {
+    splay_tree<K, V, Comparator> the_tree;
+    mutable std::shared_mutex the_mutex;
+    SplayPolicy policy;
+
+    std::optional<V> find_exclusive(const K &key, splay_action action) {
+        std::unique_lock lock{the_mutex};
+
+        const auto found = action == splay_action::semi_splay ? the_tree.find_semi_splay(key) : the_tree.find(key);
+        if(found) return found->get();
+        else return {};
+    }
+
+    public:
+    concurrent_splay_tree(SplayPolicy policy={}):
+        the_tree{},
+        the_mutex{},
+        policy{policy}
+    {}
+
+    std::optional<V> find(const K &key) {
+        splay_action action = splay_action::none;
+
+        if constexpr(!SplayPolicy::depends_on_depth) {
+            action = policy(0);
+            if(action != splay_action::none) return find_exclusive(key, action);
+        }
+
+        {
+            std::shared_lock lock{the_mutex};
+
+            const auto [val, depth] = the_tree.peek(key);
+
+            if constexpr(SplayPolicy::depends_on_depth) action = policy(depth);
+            if(action == splay_action::none) {
+                if(val) return *val;
+                else return {};
+            }
+        }
+
+        // the tree may have changed between the locks, so the key is searched for again
+        return find_exclusive(key, action);
+    }
+
+    template<typename X=K, typename Y=V> void insert(X &&key, Y &&val) {
+        std::unique_lock lock{the_mutex};
+        the_tree.insert(std::forward<X>(key), std::forward<Y>(val));
+    }
+
+    void erase(const K &key) {
+        std::unique_lock lock{the_mutex};
+        the_tree.erase(key);
+    }
+
+    void clear() {
+        std::unique_lock lock{the_mutex};
+        the_tree.clear();
+    }
+};
+
+#endif
@@ -1,6 +1,365 @@
 #include "splay_tree.h"
+#include "concurrent_splay_tree.h"
+#include "splay_cache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template<typename Tree> void check_against_map(size_t num_ops, int key_range) {
+    Tree st;
+    std::map<int, int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> key_dist(0, key_range);
+
+    for(size_t k=0; k<num_ops; ++k) {
+        const int key = key_dist(gen);
+
+        switch(gen() % 3) {
+            case 0:
+                st.insert(key, static_cast<int>(k));
+                reference[key] = static_cast<int>(k);
+                break;
+            case 1:
+                st.erase(key);
+                reference.erase(key);
+                break;
+            default:
+                if(auto it = reference.find(key); it != reference.end()) assert(st.find(key)->get() == it->second);
+                else assert(!st.find(key));
+
+                if constexpr(std::is_same_v<Tree, splay_tree<int, int>>) {
+                    if(auto it = reference.find(key); it != reference.end()) assert(st.find_semi_splay(key)->get() == it->second);
+                    else assert(!st.find_semi_splay(key));
+                }
+        }
+    }
+
+    auto it = reference.begin();
+    for(auto [key, val] : st) {
+        assert(it != reference.end() && key == it->first && val == it->second);
+        ++it;
+    }
+    assert(it == reference.end());
+
+    typename Tree::const_iterator first = st.begin();
+    assert(first == std::as_const(st).begin());
+
+    auto rit = reference.rbegin();
+    for(auto st_it = st.end(); st_it != st.begin();) {
+        --st_it;
+        assert((*st_it).first == rit->first);
+        ++rit;
+    }
+    assert(rit == reference.rend());
+
+    for(int k=0; k<1000; ++k) {
+        const int lo = key_dist(gen), hi = lo + key_dist(gen) % 100;
+
+        auto lower = st.lower_bound(lo);
+        if(auto ref_lower = reference.lower_bound(lo); ref_lower == reference.end()) assert(lower == st.end());
+        else assert((*lower).first == ref_lower->first);
+
+        auto upper = st.upper_bound(lo);
+        if(auto ref_upper = reference.upper_bound(lo); ref_upper == reference.end()) assert(upper == st.end());
+        else assert((*upper).first == ref_upper->first);
+
+        auto ref_it = reference.lower_bound(lo);
+        st.for_each_in_range(lo, hi, [&](const int &key, int &val) {
+            assert(ref_it != reference.end() && key == ref_it->first && val == ref_it->second);
+            ++ref_it;
+        });
+        assert(ref_it == reference.upper_bound(hi));
+    }
+}
+
+template<typename Tree> void check_split_join() {
+    std::vector<std::pair<int, std::string>> entries;
+    for(int k=0; k<10000; ++k) entries.emplace_back(2*k, std::to_string(k));
+
+    Tree st;
+    st.build_from_sorted(entries.begin(), entries.end());
+
+    auto is_same_as = [](Tree &tree, auto first, auto last) {
+        for(auto [key, val] : tree) {
+            if(first == last || key != first->first || val != first->second) return false;
+            ++first;
+        }
+
+        return first == last;
+    };
+    assert(is_same_as(st, entries.begin(), entries.end()));
+
+    std::mt19937 gen(3);
+    for(int k=0; k<100; ++k) {
+        const int pivot = static_cast<int>(gen() % 20002) - 1;
+        const auto middle = std::lower_bound(entries.begin(), entries.end(), pivot, [](const auto &entry, int key) { return entry.first < key; });
+
+        Tree bigger = st.split(pivot);
+        assert(is_same_as(st, entries.begin(), middle));
+        assert(is_same_as(bigger, middle, entries.end()));
+
+        // both halves keep working on their own before being put back together
+        bigger.insert(30000, "x");
+        st.erase(entries.front().first);
+        bigger.erase(30000);
+        st.insert(entries.front().first, entries.front().second);
+
+        st.join(std::move(bigger));
+        assert(is_same_as(st, entries.begin(), entries.end()));
+    }
+
+    Tree bigger = st.split(10000);
+    st.clear();
+    assert(is_same_as(bigger, entries.begin() + 5000, entries.end()));
+    for(int k=0; k<5000; ++k) st.insert(2*k, std::to_string(k));
+    assert(is_same_as(bigger, entries.begin() + 5000, entries.end()));
+    st.join(std::move(bigger));
+    assert(is_same_as(st, entries.begin(), entries.end()));
+}
+
+template<typename Tree> void check_order_statistics() {
+    Tree st;
+    std::map<int, int> reference;
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> key_dist(0, 5000);
+
+    for(int k=0; k<20000; ++k) {
+        const int key = key_dist(gen);
+        if(gen() % 3) {
+            st.insert(key, key);
+            reference[key] = key;
+        }
+        else {
+            st.erase(key);
+            reference.erase(key);
+        }
+
+        if(k % 7 == 0) {
+            Tree bigger = st.split(key_dist(gen));
+            st.join(std::move(bigger));
+        }
+    }
+    assert(st.size() == reference.size());
+
+    std::vector<int> sorted;
+    for(auto &entry : reference) sorted.push_back(entry.first);
+
+    for(int k=0; k<2000; ++k) {
+        const size_t index = gen() % (sorted.size() + 1);
+        auto it = st.select(index);
+        if(index == sorted.size()) assert(it == st.end());
+        else assert((*it).first == sorted[index]);
+
+        const int lo = key_dist(gen), hi = key_dist(gen);
+        const size_t lo_rank = std::lower_bound(sorted.begin(), sorted.end(), lo) - sorted.begin();
+        assert(st.rank(lo) == lo_rank);
+
+        const size_t in_range = lo > hi ? 0 : std::upper_bound(sorted.begin(), sorted.end(), hi) - sorted.begin() - lo_rank;
+        assert(st.count_in_range(lo, hi) == in_range);
+    }
+
+    std::vector<std::pair<int, int>> entries;
+    for(int k=0; k<1000; ++k) entries.emplace_back(k, k);
+    st.build_from_sorted(entries.begin(), entries.end());
+    for(size_t k=0; k<entries.size(); ++k) assert((*st.select(k)).first == static_cast<int>(k));
+}
+
+template<typename Policy> void check_concurrent(Policy policy) {
+    concurrent_splay_tree<int, int, std::less<int>, Policy> st{policy};
+    for(int k=0; k<10000; k+=2) st.insert(k, 2*k);
+
+    std::vector<std::thread> readers;
+    for(int t=0; t<4; ++t) {
+        readers.emplace_back([&st, t]() {
+            std::mt19937 gen(t);
+            for(int k=0; k<20000; ++k) {
+                const int key = static_cast<int>(gen() % 10000);
+                const auto val = st.find(key);
+                assert(!val || *val == 2*key);
+                if(key % 2 == 0 && key < 5000) assert(val);
+            }
+        });
+    }
+
+    // odd keys come and go while the readers run
+    for(int k=0; k<20000; ++k) {
+        const int key = 2*(k % 5000) + 1;
+        if(k % 2 == 0) st.insert(key, 2*key);
+        else st.erase(key);
+    }
+
+    for(auto &reader : readers) reader.join();
+}
+
+template<typename Splaying> void check_cache() {
+    std::map<int, int> evicted;
+    splay_cache<int, int, std::less<int>, Splaying> cache{100, {}, [&](const int &key, int &val) { evicted[key] = val; }};
+
+    for(int k=0; k<1000; ++k) {
+        cache.insert(k, k);
+        assert(cache.size() == static_cast<size_t>(std::min(k + 1, 100)));
+
+        // keep a hot set alive while the rest streams through
+        for(int hot=0; hot<10 && hot<=k; ++hot) assert(cache.find(hot));
+    }
+
+    assert(cache.stats().evictions == 900 && evicted.size() == 900);
+    for(int hot=0; hot<10; ++hot) assert(!evicted.count(hot));
+    for(auto [key, val] : evicted) assert(key == val && !cache.find(key));
+    assert(cache.stats().misses == 900);
+
+    // a byte budget, where a key costs as many bytes as its value says
+    splay_cache<int, int, std::less<int>, Splaying> bytes{1000, [](const int&, const int &val) { return static_cast<size_t>(val); }};
+    for(int k=1; k<=100; ++k) {
+        bytes.insert(k, k);
+        assert(bytes.weight() <= 1000);
+        assert(bytes.find(k));
+    }
+    bytes.insert(100, 1);
+    bytes.erase(100);
+    assert(bytes.weight() <= 1000 - 100 + 1 - 1);
+}
+
+template<typename Tree> double time_accesses(const std::vector<int> &keys, const std::vector<int> &accesses) {
+    Tree st;
+    for(int key : keys) st.insert(key, key);
+
+    const auto start = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    for(int key : accesses) checksum += st.find(key)->get();
+    const auto end = std::chrono::steady_clock::now();
+
+    assert(checksum != 0);
+    return std::chrono::duration<double>(end - start).count();
+}
+
+template<template<typename> class Allocator> void benchmark_splaying(const char *name, const std::vector<int> &keys, const std::vector<int> &accesses) {
+    using bottom_up = splay_tree<int, int, std::less<int>, Allocator, bottom_up_splaying>;
+    using top_down = splay_tree<int, int, std::less<int>, Allocator, top_down_splaying>;
+
+    std::cout << name
+        << ": bottom up " << time_accesses<bottom_up>(keys, accesses) << "s"
+        << ", top down " << time_accesses<top_down>(keys, accesses) << "s" << std::endl;
+}
+
+// split and join at a random pivot and back, the best of a few runs in seconds per pair
+template<typename Tree> double time_split_join(int num_keys) {
+    std::vector<std::pair<int, int>> entries;
+    for(int k=0; k<num_keys; ++k) entries.emplace_back(k, k);
+
+    Tree st;
+    st.build_from_sorted(entries.begin(), entries.end());
+
+    constexpr int num_rounds = 20000;
+    std::mt19937 gen(5);
+    double best = std::numeric_limits<double>::max();
+
+    for(int run=0; run<3; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        for(int k=0; k<num_rounds; ++k) {
+            Tree bigger = st.split(static_cast<int>(gen() % num_keys));
+            st.join(std::move(bigger));
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / num_rounds);
+    }
+
+    assert(std::distance(st.begin(), st.end()) == num_keys);
+    return best;
+}
+
+// a split and join pair only touches a splay path, the cost should barely move with the size of the tree
+template<template<typename> class Allocator, typename Splaying> void benchmark_split_join(const char *name) {
+    using tree_t = splay_tree<int, int, std::less<int>, Allocator, Splaying>;
+
+    const double small = time_split_join<tree_t>(1 << 12), large = time_split_join<tree_t>(1 << 20);
+    std::cout << name
+        << " split and join: " << small * 1e6 << " us at 2^12 keys, " << large * 1e6 << " us at 2^20 keys"
+        << ", ratio " << large / small << std::endl;
+}
+
+template<typename Policy> void benchmark_concurrent(const char *name, Policy policy, size_t num_threads) {
+    constexpr int num_keys = 1 << 18;
+    constexpr size_t ops_per_thread = 1 << 20;
+
+    concurrent_splay_tree<int, int, std::less<int>, Policy> st{policy};
+    for(int k=0; k<num_keys; ++k) st.insert(k * 7919 % num_keys, k);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for(size_t t=0; t<num_threads; ++t) {
+        threads.emplace_back([&st, t]() {
+            std::mt19937 gen(static_cast<unsigned>(t));
+            std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+
+            // 99% reads, the writes overwrite existing keys so the size stays put
+            for(size_t k=0; k<ops_per_thread; ++k) {
+                const int key = key_dist(gen);
+                if(k % 100 == 0) st.insert(key, key);
+                else st.find(key);
+            }
+        });
+    }
+    for(auto &thread : threads) thread.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " with " << num_threads << " threads: " << num_threads * ops_per_thread / seconds / 1e6 << " Mops/s" << std::endl;
+}
+
+void benchmark() {
+    constexpr int num_keys = 1 << 20;
+    constexpr size_t num_accesses = 1 << 22;
+
+    std::mt19937 gen(7);
+
+    std::vector<int> keys(num_keys);
+    for(int k=0; k<num_keys; ++k) keys[k] = k + 1;
+    std::shuffle(keys.begin(), keys.end(), gen);
+
+    std::vector<int> sequential(num_accesses), uniform(num_accesses), zipf(num_accesses);
+    std::uniform_int_distribution<int> uniform_dist(1, num_keys);
+
+    std::vector<double> weights(num_keys);
+    for(int k=0; k<num_keys; ++k) weights[k] = 1.0 / (k + 1);
+    std::discrete_distribution<int> zipf_dist(weights.begin(), weights.end());
+
+    for(size_t k=0; k<num_accesses; ++k) {
+        sequential[k] = static_cast<int>(k % num_keys) + 1;
+        uniform[k] = uniform_dist(gen);
+        zipf[k] = keys[zipf_dist(gen)];
+    }
+
+    benchmark_splaying<splay_tree_arena>("sequential", keys, sequential);
+    benchmark_splaying<splay_tree_arena>("uniform", keys, uniform);
+    benchmark_splaying<splay_tree_arena>("zipf", keys, zipf);
+
+    benchmark_split_join<splay_tree_arena, bottom_up_splaying>("arena, bottom up");
+    benchmark_split_join<splay_tree_arena, top_down_splaying>("arena, top down");
+    benchmark_split_join<splay_tree_heap_allocator, bottom_up_splaying>("heap, bottom up");
+
+    for(size_t num_threads=1; num_threads<=std::max(1u, std::thread::hardware_concurrency()); num_threads*=2) {
+        benchmark_concurrent("always splay", always_splay{}, num_threads);
+        benchmark_concurrent("splay 1% of lookups", probabilistic_splay{0.01}, num_threads);
+        benchmark_concurrent("splay past depth 32", depth_threshold_splay{32}, num_threads);
+        benchmark_concurrent("semi splay", always_semi_splay{}, num_threads);
+    }
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark();
+        return 0;
+    }
 
-int main() {
     splay_tree<int, int> st;
     
     st.insert(6, 6);
@@ -23,4 +382,43 @@ int main() {
 
     for(int k=9; k<30; ++k) st.insert(k % 2 == 0 ? k : -k, k);
     st.print();
+
+    check_against_map<splay_tree<int, int>>(100000, 1000);
+    check_against_map<splay_tree<int, int, std::less<int>, splay_tree_heap_allocator>>(100000, 1000);
+    check_against_map<splay_tree<int, int, std::less<int>, splay_tree_arena, top_down_splaying>>(100000, 1000);
+    check_against_map<splay_tree<int, int, std::less<int>, splay_tree_heap_allocator, top_down_splaying>>(100000, 1000);
+
+    check_split_join<splay_tree<int, std::string>>();
+    check_split_join<splay_tree<int, std::string, std::less<int>, splay_tree_heap_allocator>>();
+    check_split_join<splay_tree<int, std::string, std::less<int>, splay_tree_arena, top_down_splaying>>();
+
+    check_order_statistics<splay_tree<int, int, std::less<int>, splay_tree_arena, bottom_up_splaying, order_statistics>>();
+    check_order_statistics<splay_tree<int, int, std::less<int>, splay_tree_arena, top_down_splaying, order_statistics>>();
+
+    check_concurrent(always_splay{});
+    check_concurrent(probabilistic_splay{0.1});
+    check_concurrent(depth_threshold_splay{8});
+    check_concurrent(always_semi_splay{});
+
+    check_cache<bottom_up_splaying>();
+    check_cache<top_down_splaying>();
+
+    // clearing rewinds the arena, chunks lent to the split off half must survive that
+    splay_tree<int, int> lender;
+    for(int k=0; k<10000; ++k) lender.insert(k, k);
+    splay_tree<int, int> borrower = lender.split(5000);
+    lender.clear();
+    for(int k=0; k<10000; ++k) lender.insert(-k, -k);
+    int expected = 5000;
+    for(auto [key, val] : borrower) assert(key == expected && val == expected++);
+    assert(expected == 10000);
+
+    // sequential inserts leave a path, tearing it down must not recurse
+    splay_tree<int, std::string> degenerate;
+    for(int k=0; k<1000000; ++k) degenerate.insert(k, std::to_string(k));
+    degenerate.clear();
+    for(int k=0; k<1000000; ++k) degenerate.insert(k, std::to_string(k));
+
+    splay_tree<int, std::string, std::less<int>, splay_tree_arena, top_down_splaying> top_down_degenerate;
+    for(int k=0; k<1000000; ++k) top_down_degenerate.insert(k, std::to_string(k));
 }
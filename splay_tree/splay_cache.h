@@ -0,0 +1,91 @@
+#ifndef SPLAY_CACHE_H
+#define SPLAY_CACHE_H
+
+#include "splay_tree.h"
+
+#include <functional>
+
+
+struct splay_cache_stats {
+    size_t hits, misses, evictions;
+};
+
+// bounded splay_tree for hot keys. splaying keeps recently used keys near the root,
+// so once the budget is exceeded the entries deepest in the heavier subtrees go first
+template<
+    typename K,
+    typename V,
+    typename Comparator=std::less<K>,
+    typename Splaying=top_down_splaying
+> class splay_cache {
+    using weigh_t = std::function<size_t(const K&, const V&)>;
+    using evict_t = std::function<void(const K&, V&)>;
+
+    splay_tree<K, V, Comparator, splay_tree_arena, Splaying, order_statistics> the_tree;
+    size_t budget, used;
+    weigh_t weigh;
+    evict_t on_evict;
+    splay_cache_stats the_stats;
+
+    size_t weight_of(const K &key, const V &val) const {
+        return weigh ? weigh(key, val) : 1;
+    }
+
+    public:
+    // without weigh every entry counts as one against the budget, which then bounds the number of nodes
+    splay_cache(size_t budget, weigh_t weigh={}, evict_t on_evict={}):
+        the_tree{},
+        budget{budget},
+        used{0},
+        weigh{std::move(weigh)},
+        on_evict{std::move(on_evict)},
+        the_stats{}
+    {}
+
+    std::optional<std::reference_wrapper<V>> find(const K &key) {
+        auto found = the_tree.find(key);
+
+        if(found) ++the_stats.hits;
+        else ++the_stats.misses;
+
+        return found;
+    }
+
+    // the entry just inserted is never the one evicted to make room for it
+    template<typename X=K, typename Y=V> void insert(X &&key, Y &&val) {
+        if(auto found = the_tree.find(key)) used -= weight_of(key, found->get());
+
+        auto [inserted_key, inserted_val] = the_tree.insert(std::forward<X>(key), std::forward<Y>(val));
+        used += weight_of(inserted_key, inserted_val);
+
+        while(used > budget && the_tree.size() > 1) {
+            the_tree.erase_coldest([this](const K &cold_key, V &cold_val) {
+                used -= weight_of(cold_key, cold_val);
+                ++the_stats.evictions;
+
+                if(on_evict) on_evict(cold_key, cold_val);
+            });
+
+            // evicting splays, so the new entry is brought back up before looking for the next victim
+            the_tree.find(inserted_key);
+        }
+    }
+
+    void erase(const K &key) {
+        if(auto found = the_tree.find(key)) {
+            used -= weight_of(key, found->get());
+            the_tree.erase(key);
+        }
+    }
+
+    void clear() {
+        the_tree.clear();
+        used = 0;
+    }
+
+    size_t size() const { return the_tree.size(); }
+    size_t weight() const { return used; }
+    const splay_cache_stats &stats() const { return the_stats; }
+};
+
+#endif
@@ -1,27 +1,220 @@
 #ifndef SPLAY_TREE_H
 #define SPLAY_TREE_H
 
+#include <algorithm>
 #include <iostream>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// hands out nodes from contiguous chunks, erased nodes are recycled through an intrusive free list.
+// the chunks and the free list live in a reference counted pool, a tree split off another one shares
+// its pool so split and join hand nodes over without any bookkeeping. trees sharing a pool must not be
+// used from different threads at once
+template<typename Node, size_t chunk_size = 1024> class splay_tree_arena {
+    union slot {
+        slot *next;
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+
+    using chunk_t = std::shared_ptr<slot[]>;
+
+    // nodes are carved out of current, full chunks may hold live nodes, spare ones are empty.
+    // a chunk is also held by another pool when a join took nodes from a pool that stayed in use
+    struct pool {
+        std::vector<chunk_t> full, spare;
+        chunk_t current;
+        size_t used = chunk_size;
+        slot *free_head = nullptr, *free_tail = nullptr;
+    };
+
+    std::shared_ptr<pool> the_pool;
+
+    public:
+    // nodes can be forgotten without visiting them when their destructors are trivial
+    static constexpr bool bulk_reset = true;
+
+    splay_tree_arena():
+        the_pool{}
+    {}
+
+    splay_tree_arena(const splay_tree_arena&) = delete;
+    splay_tree_arena &operator=(const splay_tree_arena&) = delete;
+
+    template<typename... Args> Node *create(Args&&... args) {
+        if(!the_pool) the_pool = std::make_shared<pool>();
+        pool &p = *the_pool;
+
+        slot *the_slot;
+
+        if(p.free_head) {
+            the_slot = p.free_head;
+            p.free_head = p.free_head->next;
+            if(!p.free_head) p.free_tail = nullptr;
+        }
+        else {
+            if(p.used == chunk_size) {
+                if(p.current) p.full.emplace_back(std::move(p.current));
+
+                if(p.spare.empty()) {
+                    p.current.reset(new slot[chunk_size]);
+                }
+                else {
+                    p.current = std::move(p.spare.back());
+                    p.spare.pop_back();
+                }
+
+                p.used = 0;
+            }
+
+            the_slot = &p.current[p.used++];
+        }
+
+        return new (the_slot->storage) Node{std::forward<Args>(args)...};
+    }
+
+    void destroy(Node *node) {
+        node->~Node();
+
+        pool &p = *the_pool;
+        slot *the_slot = reinterpret_cast<slot*>(node);
+        the_slot->next = p.free_head;
+        p.free_head = the_slot;
+        if(!p.free_tail) p.free_tail = the_slot;
+    }
+
+    // every node handed out so far is considered dead. a pool still shared with another tree holds
+    // its nodes too, so it is left to that tree, and chunks held by another pool are not reused either
+    void reset() {
+        if(!the_pool) return;
+
+        if(the_pool.use_count() > 1) {
+            the_pool.reset();
+            return;
+        }
+
+        pool &p = *the_pool;
+        if(p.current) p.full.emplace_back(std::move(p.current));
+
+        for(chunk_t &chunk : p.full) {
+            if(chunk.use_count() == 1) p.spare.emplace_back(std::move(chunk));
+        }
+        p.full.clear();
+
+        p.used = chunk_size;
+        p.free_head = p.free_tail = nullptr;
+    }
+
+    // nodes of other are about to belong to this arena's tree, O(1)
+    void share(splay_tree_arena &other) {
+        if(!other.the_pool) other.the_pool = std::make_shared<pool>();
+        the_pool = other.the_pool;
+    }
+
+    // nodes of other now belong to this arena's tree, leaving other empty. nothing to do when both
+    // already share a pool, otherwise O(number of chunks of other)
+    void absorb(splay_tree_arena &&other) {
+        if(!other.the_pool || other.the_pool == the_pool) {
+            other.the_pool.reset();
+            return;
+        }
+
+        if(!the_pool) {
+            the_pool = std::move(other.the_pool);
+            return;
+        }
+
+        pool &mine = *the_pool, &theirs = *other.the_pool;
+
+        if(other.the_pool.use_count() == 1) {
+            if(theirs.current) mine.full.emplace_back(std::move(theirs.current));
+            mine.full.insert(mine.full.end(), std::make_move_iterator(theirs.full.begin()), std::make_move_iterator(theirs.full.end()));
+            mine.spare.insert(mine.spare.end(), std::make_move_iterator(theirs.spare.begin()), std::make_move_iterator(theirs.spare.end()));
+
+            if(theirs.free_head) {
+                theirs.free_tail->next = mine.free_head;
+                if(!mine.free_head) mine.free_tail = theirs.free_tail;
+                mine.free_head = theirs.free_head;
+            }
+        }
+        else {
+            // trees split off other still allocate from its pool, only keep its chunks alive
+            if(theirs.current) mine.full.emplace_back(theirs.current);
+            mine.full.insert(mine.full.end(), theirs.full.begin(), theirs.full.end());
+        }
+
+        other.the_pool.reset();
+    }
+};
+
+template<typename Node> struct splay_tree_heap_allocator {
+    static constexpr bool bulk_reset = false;
+
+    template<typename... Args> Node *create(Args&&... args) {
+        return new Node{std::forward<Args>(args)...};
+    }
+
+    void destroy(Node *node) { delete node; }
 
+    void reset() {}
 
-template<typename K, typename V, typename Comparator=std::less<K>> class splay_tree {
-    struct splay_tree_node {
+    void share(splay_tree_heap_allocator&) {}
+
+    void absorb(splay_tree_heap_allocator&&) {}
+};
+
+
+// splays the accessed node up along parent pointers after the search has found it
+struct bottom_up_splaying {};
+// restructures on the way down in a single pass, nodes carry no parent pointer
+struct top_down_splaying {};
+
+struct no_order_statistics {};
+// every node keeps the size of its subtree, enabling select, rank and count_in_range
+struct order_statistics {};
+
+
+template<
+    typename K,
+    typename V,
+    typename Comparator=std::less<K>,
+    template<typename> class Allocator=splay_tree_arena,
+    typename Splaying=bottom_up_splaying,
+    typename Statistics=no_order_statistics
+> class splay_tree {
+    static constexpr bool is_top_down = std::is_same_v<Splaying, top_down_splaying>;
+    static constexpr bool has_sizes = std::is_same_v<Statistics, order_statistics>;
+
+    struct splay_tree_node;
+
+    struct parent_link { splay_tree_node *parent = nullptr; };
+    struct no_parent_link {};
+    struct subtree_size { size_t size = 1; };
+    struct no_subtree_size {};
+    struct no_ancestors {};
+
+    struct splay_tree_node:
+        std::conditional_t<is_top_down, no_parent_link, parent_link>,
+        std::conditional_t<has_sizes, subtree_size, no_subtree_size>
+    {
         K key;
         V val;
-        splay_tree_node* parent, *left_child, *right_child;
+        splay_tree_node *left_child, *right_child;
 
         template<typename X=K, typename Y=V> splay_tree_node(
                 X &&key,
                 Y &&val,
-                splay_tree_node *parent,
                 splay_tree_node *left_child,
                 splay_tree_node *right_child
                 ):
             key{std::forward<X>(key)},
             val{std::forward<Y>(val)},
-            parent{parent},
             left_child{left_child},
             right_child{right_child}
         {}
@@ -35,11 +228,6 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
             if(right_child) right_child->print(depth + 1);
             else std::cout << std::endl;
         } 
-
-        ~splay_tree_node() {
-            delete left_child;
-            delete right_child;
-        }
     };
 
 
@@ -70,6 +258,21 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         else return nullptr;
     }
 
+    static size_t size_of(const splay_tree_node *node) {
+        return node ? node->size : 0;
+    }
+
+    // recomputes the subtree size from the children, which have to be up to date
+    static void update([[maybe_unused]] splay_tree_node *node) {
+        if constexpr(has_sizes) node->size = 1 + size_of(node->left_child) + size_of(node->right_child);
+    }
+
+    static void adopt([[maybe_unused]] splay_tree_node *child, [[maybe_unused]] splay_tree_node *parent) {
+        if constexpr(!is_top_down) {
+            if(child) child->parent = parent;
+        }
+    }
+
     splay_tree_node* left(splay_tree_node* child, splay_tree_node* parent) {
         splay_tree_node *child1 = child->left_child;
 
@@ -77,9 +280,13 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         parent->parent = child;
 
         parent->right_child = child1;
+        adopt(child1, parent);
 
         child->left_child = parent;
 
+        update(parent);
+        update(child);
+
         return child;
     }
 
@@ -90,9 +297,13 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         parent->parent = child;
 
         parent->left_child = child1;
+        adopt(child1, parent);
 
         child->right_child = parent;
 
+        update(parent);
+        update(child);
+
         return child;
     }
 
@@ -105,12 +316,18 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         grandparent->parent = parent;
 
         grandparent->right_child = child1;
+        adopt(child1, grandparent);
 
         parent->left_child = grandparent;
         parent->right_child = child2;
+        adopt(child2, parent);
 
         child->left_child = parent;
 
+        update(grandparent);
+        update(parent);
+        update(child);
+
         return child;
     }
 
@@ -123,12 +340,18 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         grandparent->parent = parent;
 
         grandparent->left_child = child2;
+        adopt(child2, grandparent);
 
         parent->left_child = child1;
         parent->right_child = grandparent;
+        adopt(child1, parent);
 
         child->right_child = parent;
 
+        update(grandparent);
+        update(parent);
+        update(child);
+
         return child;
     }
     splay_tree_node* left_right(splay_tree_node* child, splay_tree_node* parent, splay_tree_node* grandparent) {
@@ -140,12 +363,18 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         grandparent->parent = child;
 
         grandparent->left_child = child2;
+        adopt(child2, grandparent);
 
         parent->right_child = child1;
+        adopt(child1, parent);
 
         child->left_child = parent;
         child->right_child = grandparent;
 
+        update(parent);
+        update(grandparent);
+        update(child);
+
         return child;
     }
     splay_tree_node* right_left(splay_tree_node* child, splay_tree_node* parent, splay_tree_node* grandparent) {
@@ -157,12 +386,18 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         grandparent->parent = child;
 
         grandparent->right_child = child1;
+        adopt(child1, grandparent);
 
         parent->left_child = child2;
+        adopt(child2, parent);
 
         child->left_child = grandparent;
         child->right_child = parent;
 
+        update(grandparent);
+        update(parent);
+        update(child);
+
         return child;
     }
 
@@ -199,21 +434,378 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         }
     }
 
+    // zig-zig steps only rotate the parent over the grandparent and carry on from the parent,
+    // roughly halving the depth of the access path while restructuring much less than splay
+    void semi_splay(splay_tree_node *node) {
+        if(!node) return;
+
+        while(node->parent) {
+            splay_tree_node *parent = node->parent;
+
+            if(parent->parent) {
+                splay_tree_node* grandparent = parent->parent;
+
+                splay_tree_node *&child_ptr = grandparent->parent ?
+                    (is_left_child(grandparent, grandparent->parent) ? grandparent->parent->left_child : grandparent->parent->right_child) :
+                    the_tree;
+
+                if(is_left_child(parent, grandparent)) {
+                    if(is_left_child(node, parent)) {
+                        child_ptr = right(parent, grandparent);
+                        node = parent;
+                    }
+                    else child_ptr = left_right(node, parent, grandparent);
+                }
+                else {
+                    if(is_left_child(node, parent)) child_ptr = right_left(node, parent, grandparent);
+                    else {
+                        child_ptr = left(parent, grandparent);
+                        node = parent;
+                    }
+                }
+            }
+            else {
+                the_tree = is_left_child(node, parent) ? right(node, parent) : left(node, parent);
+                return;
+            }
+        }
+    }
+
+    // Sleator and Tarjan's top down splay: nodes smaller than the key are hung off
+    // the right spine of a left tree, bigger ones off the left spine of a right tree
+    splay_tree_node *splay_top_down(splay_tree_node *root, const K &key) {
+        splay_tree_node *left_tree = nullptr, *right_tree = nullptr;
+        splay_tree_node **left_hook = &left_tree, **right_hook = &right_tree;
+        [[maybe_unused]] size_t left_size = 0, right_size = 0;
+
+        while(true) {
+            if(comp(key, root->key)) {
+                if(!root->left_child) break;
+                if(comp(key, root->left_child->key)) {
+                    splay_tree_node *child = root->left_child;
+                    root->left_child = child->right_child;
+                    child->right_child = root;
+                    update(root);
+                    root = child;
+
+                    if(!root->left_child) break;
+                }
+
+                *right_hook = root;
+                right_hook = &root->left_child;
+                if constexpr(has_sizes) right_size += 1 + size_of(root->right_child);
+                root = root->left_child;
+            }
+            else if(comp(root->key, key)) {
+                if(!root->right_child) break;
+                if(comp(root->right_child->key, key)) {
+                    splay_tree_node *child = root->right_child;
+                    root->right_child = child->left_child;
+                    child->left_child = root;
+                    update(root);
+                    root = child;
+
+                    if(!root->right_child) break;
+                }
+
+                *left_hook = root;
+                left_hook = &root->right_child;
+                if constexpr(has_sizes) left_size += 1 + size_of(root->left_child);
+                root = root->right_child;
+            }
+            else break;
+        }
+
+        if constexpr(has_sizes) {
+            // the linked nodes lie on the right spine of the left tree and the left spine of the
+            // right tree, top first, so their sizes shrink by what hangs off the other side
+            left_size += size_of(root->left_child);
+            right_size += size_of(root->right_child);
+            *left_hook = nullptr;
+            *right_hook = nullptr;
+
+            for(splay_tree_node *node = left_tree; node; node = node->right_child) {
+                node->size = left_size;
+                left_size -= 1 + size_of(node->left_child);
+            }
+            for(splay_tree_node *node = right_tree; node; node = node->left_child) {
+                node->size = right_size;
+                right_size -= 1 + size_of(node->right_child);
+            }
+        }
+
+        *left_hook = root->left_child;
+        *right_hook = root->right_child;
+        root->left_child = left_tree;
+        root->right_child = right_tree;
+        update(root);
+
+        return root;
+    }
+
+    // the biggest key ends up at the root without a right child, assumes non empty
+    void splay_biggest() {
+        splay_tree_node *biggest = the_tree;
+        while(biggest->right_child) biggest = biggest->right_child;
+
+        if constexpr(is_top_down) the_tree = splay_top_down(the_tree, biggest->key);
+        else splay(biggest);
+    }
+
+    // lays out n sorted entries in order so that every subtree is balanced
+    template<typename It> splay_tree_node *build_balanced(It &it, size_t n) {
+        if(n == 0) return nullptr;
+
+        splay_tree_node *left_child = build_balanced(it, n/2);
+        splay_tree_node *node = allocator.create(it->first, it->second, left_child, nullptr);
+        ++it;
+        node->right_child = build_balanced(it, n - n/2 - 1);
+
+        adopt(node->left_child, node);
+        adopt(node->right_child, node);
+        update(node);
+
+        return node;
+    }
+
+    // joins the subtrees of the root in its place
+    void erase_root() {
+        splay_tree_node *root = the_tree;
+        splay_tree_node *right_child = root->right_child;
+        splay_tree_node *left_child = root->left_child;
+
+        if(left_child) {
+            if constexpr(is_top_down) {
+                // everything on the left is smaller than the root, so splaying for it there brings up the maximum
+                the_tree = splay_top_down(left_child, root->key);
+            }
+            else {
+                left_child->parent = nullptr;
+
+                the_tree = left_child;
+                splay_biggest();
+            }
+
+            the_tree->right_child = right_child;
+            adopt(right_child, the_tree);
+            update(the_tree);
+        }
+        else {
+            the_tree = right_child;
+            adopt(right_child, nullptr);
+        }
+
+        allocator.destroy(root);
+    }
+
+    // brings the key, or the last node visited looking for it, to the root
     void splay(const K& key) {
-        splay_tree_node* node = traverse(key);
-        splay(node);
+        if constexpr(is_top_down) {
+            if(the_tree) the_tree = splay_top_down(the_tree, key);
+        }
+        else {
+            splay_tree_node* node = traverse_parent(key);
+            splay(node);
+        }
     }
 
     Comparator comp;
+    Allocator<splay_tree_node> allocator;
     splay_tree_node *the_tree;
 
     public:
     splay_tree():
         comp{},
+        allocator{},
         the_tree{}
     {}
 
-    std::optional<V&> find(const K& key) {
+    splay_tree(const splay_tree&) = delete;
+    splay_tree &operator=(const splay_tree&) = delete;
+
+    splay_tree(splay_tree &&other):
+        comp{other.comp},
+        allocator{},
+        the_tree{std::exchange(other.the_tree, nullptr)}
+    {
+        allocator.absorb(std::move(other.allocator));
+    }
+
+    splay_tree &operator=(splay_tree &&other) {
+        if(this != &other) {
+            clear();
+
+            comp = other.comp;
+            allocator.absorb(std::move(other.allocator));
+            the_tree = std::exchange(other.the_tree, nullptr);
+        }
+
+        return *this;
+    }
+
+    // walks the tree in order without splaying, ancestors go on a stack when nodes have no parent pointer.
+    // any operation that splays invalidates iterators
+    template<bool is_const> class basic_iterator {
+        friend class splay_tree;
+        template<bool> friend class basic_iterator;
+
+        using tree_t = std::conditional_t<is_const, const splay_tree, splay_tree>;
+        using ancestors_t = std::conditional_t<is_top_down, std::vector<splay_tree_node*>, no_ancestors>;
+
+        tree_t *tree;
+        splay_tree_node *current;
+        ancestors_t ancestors;
+
+        basic_iterator(tree_t *tree, splay_tree_node *current):
+            tree{tree},
+            current{current},
+            ancestors{}
+        {}
+
+        void descend(splay_tree_node *child) {
+            if constexpr(is_top_down) ancestors.push_back(current);
+            current = child;
+        }
+
+        void ascend() {
+            if constexpr(is_top_down) {
+                if(ancestors.empty()) {
+                    current = nullptr;
+                }
+                else {
+                    current = ancestors.back();
+                    ancestors.pop_back();
+                }
+            }
+            else {
+                current = current->parent;
+            }
+        }
+
+        void leftmost() { while(current->left_child) descend(current->left_child); }
+        void rightmost() { while(current->right_child) descend(current->right_child); }
+
+        public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<const K, V>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const K&, std::conditional_t<is_const, const V&, V&>>;
+        using pointer = void;
+
+        basic_iterator():
+            tree{},
+            current{},
+            ancestors{}
+        {}
+
+        template<bool other_const, typename=std::enable_if_t<is_const && !other_const>> basic_iterator(const basic_iterator<other_const> &other):
+            tree{other.tree},
+            current{other.current},
+            ancestors{other.ancestors}
+        {}
+
+        reference operator*() const { return {current->key, current->val}; }
+
+        basic_iterator &operator++() {
+            if(current->right_child) {
+                descend(current->right_child);
+                leftmost();
+            }
+            else {
+                splay_tree_node *child;
+                do {
+                    child = current;
+                    ascend();
+                } while(current && current->right_child == child);
+            }
+
+            return *this;
+        }
+
+        // decrementing end() lands on the biggest key, assumes non empty
+        basic_iterator &operator--() {
+            if(!current) {
+                current = tree->the_tree;
+                rightmost();
+            }
+            else if(current->left_child) {
+                descend(current->left_child);
+                rightmost();
+            }
+            else {
+                splay_tree_node *child;
+                do {
+                    child = current;
+                    ascend();
+                } while(current && current->left_child == child);
+            }
+
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator prev = *this;
+            ++*this;
+            return prev;
+        }
+
+        basic_iterator operator--(int) {
+            basic_iterator prev = *this;
+            --*this;
+            return prev;
+        }
+
+        bool operator==(const basic_iterator &other) const { return current == other.current; }
+        bool operator!=(const basic_iterator &other) const { return current != other.current; }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    iterator begin() {
+        iterator it{this, the_tree};
+        if(the_tree) it.leftmost();
+        return it;
+    }
+
+    const_iterator begin() const {
+        const_iterator it{this, the_tree};
+        if(the_tree) it.leftmost();
+        return it;
+    }
+
+    iterator end() { return {this, nullptr}; }
+    const_iterator end() const { return {this, nullptr}; }
+
+    // both splay the boundary to the root, so walking on from there does no further splaying
+    iterator lower_bound(const K &key) {
+        if(!the_tree) return end();
+
+        splay(key);
+
+        iterator it{this, the_tree};
+        if(comp(the_tree->key, key)) ++it;
+        return it;
+    }
+
+    iterator upper_bound(const K &key) {
+        if(!the_tree) return end();
+
+        splay(key);
+
+        iterator it{this, the_tree};
+        if(!comp(key, the_tree->key)) ++it;
+        return it;
+    }
+
+    // visits every key in [lo, hi] in order, O(log n + k) amortized
+    template<typename Func> void for_each_in_range(const K &lo, const K &hi, Func &&fn) {
+        for(iterator it = lower_bound(lo); it.current && !comp(hi, it.current->key); ++it) {
+            fn(it.current->key, it.current->val);
+        }
+    }
+
+    std::optional<std::reference_wrapper<V>> find(const K& key) {
         if(!the_tree) return {};
 
         splay(key);
@@ -222,30 +814,85 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
         else return {};
     }
 
-    template<typename X=K, typename Y=V> void insert(X &&key, Y &&val) {
-        splay_tree_node* parent = traverse_parent(std::forward<X>(key));
+    // looks the key up without restructuring, so it is safe to share between readers.
+    // also reports how deep the search went, to let callers decide whether to splay
+    std::pair<const V*, size_t> peek(const K& key) const {
+        size_t depth = 0;
+
+        for(const splay_tree_node *current = the_tree; current; ++depth) {
+            if(comp(key, current->key)) current = current->left_child;
+            else if(key == current->key) return {&current->val, depth};
+            else current = current->right_child;
+        }
+
+        return {nullptr, depth};
+    }
+
+    std::optional<std::reference_wrapper<V>> find_semi_splay(const K& key) {
+        static_assert(!is_top_down, "semi splaying walks parent pointers");
+
+        splay_tree_node *node = traverse_parent(key);
+        semi_splay(node);
+
+        if(node && node->key == key) return node->val;
+        else return {};
+    }
+
+    // the inserted entry ends up at the root, a reference to it is handed back
+    template<typename X=K, typename Y=V> std::pair<const K&, V&> insert(X &&key, Y &&val) {
+        if constexpr(is_top_down) {
+            if(!the_tree) {
+                the_tree = allocator.create(std::forward<X>(key), std::forward<Y>(val), nullptr, nullptr);
+                return {the_tree->key, the_tree->val};
+            }
 
-        if(parent) {
-            if(comp(key, parent->key)) {
-                if(parent->left_child) parent->left_child->val = std::forward<Y>(val);
-                else parent->left_child = new splay_tree_node{std::forward<X>(key), std::forward<Y>(val), parent, nullptr, nullptr};
+            splay(key);
 
-                splay(parent->left_child);
+            if(key == the_tree->key) {
+                the_tree->val = std::forward<Y>(val);
             }
-            else if(key == parent->key) {
-                parent->val = std::forward<Y>(val);
-                splay(parent);
+            else if(comp(key, the_tree->key)) {
+                splay_tree_node *left_child = the_tree->left_child;
+                the_tree->left_child = nullptr;
+                update(the_tree);
+                the_tree = allocator.create(std::forward<X>(key), std::forward<Y>(val), left_child, the_tree);
+                update(the_tree);
             }
             else {
-                if(parent->right_child) parent->right_child->val = std::forward<Y>(val);
-                else parent->right_child = new splay_tree_node{std::forward<X>(key), std::forward<Y>(val), parent, nullptr, nullptr};
-
-                splay(parent->right_child);
+                splay_tree_node *right_child = the_tree->right_child;
+                the_tree->right_child = nullptr;
+                update(the_tree);
+                the_tree = allocator.create(std::forward<X>(key), std::forward<Y>(val), the_tree, right_child);
+                update(the_tree);
             }
         }
         else {
-            the_tree = new splay_tree_node{std::forward<X>(key), std::forward<Y>(val), nullptr, nullptr, nullptr};
+            splay_tree_node* parent = traverse_parent(std::forward<X>(key));
+
+            if(parent) {
+                if(comp(key, parent->key)) {
+                    parent->left_child = allocator.create(std::forward<X>(key), std::forward<Y>(val), nullptr, nullptr);
+                    adopt(parent->left_child, parent);
+
+                    splay(parent->left_child);
+                }
+                else if(key == parent->key) {
+                    parent->val = std::forward<Y>(val);
+                    splay(parent);
+                }
+                else {
+                    parent->right_child = allocator.create(std::forward<X>(key), std::forward<Y>(val), nullptr, nullptr);
+                    adopt(parent->right_child, parent);
+
+                    splay(parent->right_child);
+                }
+            }
+            else {
+                the_tree = allocator.create(std::forward<X>(key), std::forward<Y>(val), nullptr, nullptr);
+            }
         }
+
+        return {the_tree->key, the_tree->val};
     }
 
     void erase(const K &key) {
@@ -253,38 +900,168 @@ template<typename K, typename V, typename Comparator=std::less<K>> class splay_t
 
         splay(key);
 
-        if(key == the_tree->key) {
-            splay_tree_node *right_child = the_tree->right_child;
-            splay_tree_node *left_child = the_tree->left_child;
+        if(key == the_tree->key) erase_root();
+    }
 
-            the_tree->right_child = nullptr;
-            the_tree->left_child = nullptr;
-            delete the_tree;
+    // walks into the heavier subtree down to a leaf, about as far from the recently splayed keys as
+    // the tree gets, and hands it to fn before erasing it. the splay that removes the leaf pays for
+    // the walk, so this is O(log n) amortized
+    template<typename Func> void erase_coldest(Func &&fn) {
+        static_assert(has_sizes, "erase_coldest needs order_statistics");
+        if(!the_tree) return;
 
-            if(left_child) {
-                left_child->parent = nullptr;
+        splay_tree_node *coldest = the_tree;
+        while(coldest->left_child || coldest->right_child) {
+            coldest = size_of(coldest->left_child) > size_of(coldest->right_child) ? coldest->left_child : coldest->right_child;
+        }
 
-                the_tree = left_child;
+        if constexpr(is_top_down) the_tree = splay_top_down(the_tree, coldest->key);
+        else splay(coldest);
+
+        fn(the_tree->key, the_tree->val);
+        erase_root();
+    }
+
+    size_t size() const {
+        static_assert(has_sizes, "size needs order_statistics");
+        return size_of(the_tree);
+    }
 
-                splay_tree_node *biggest = left_child;
-                while(biggest->right_child) biggest = biggest->right_child;
-                splay(biggest);
+    // the k-th smallest key counting from 0, splayed to the root
+    iterator select(size_t k) {
+        static_assert(has_sizes, "select needs order_statistics");
+        if(k >= size_of(the_tree)) return end();
 
-                the_tree->right_child = right_child;
-                if(right_child) right_child->parent = the_tree;
+        splay_tree_node *current = the_tree;
+        while(true) {
+            const size_t left_size = size_of(current->left_child);
+
+            if(k < left_size) {
+                current = current->left_child;
+            }
+            else if(k == left_size) {
+                break;
             }
             else {
-                the_tree = right_child;
-                if(right_child) right_child->parent = nullptr;
+                k -= left_size + 1;
+                current = current->right_child;
+            }
+        }
 
-                return;
+        if constexpr(is_top_down) the_tree = splay_top_down(the_tree, current->key);
+        else splay(current);
+
+        return {this, the_tree};
+    }
+
+    // number of keys smaller than key
+    size_t rank(const K &key) {
+        static_assert(has_sizes, "rank needs order_statistics");
+        if(!the_tree) return 0;
+
+        splay(key);
+
+        return size_of(the_tree->left_child) + (comp(the_tree->key, key) ? 1 : 0);
+    }
+
+    // number of keys in [lo, hi]
+    size_t count_in_range(const K &lo, const K &hi) {
+        static_assert(has_sizes, "count_in_range needs order_statistics");
+        if(!the_tree || comp(hi, lo)) return 0;
+
+        splay(hi);
+        const size_t not_bigger = size_of(the_tree->left_child) + (comp(hi, the_tree->key) ? 0 : 1);
+
+        return not_bigger - rank(lo);
+    }
+
+    // keeps the keys smaller than key and returns a tree with the rest, O(log n) amortized.
+    // the returned tree allocates from this tree's arena pool from then on
+    splay_tree split(const K &key) {
+        splay_tree bigger;
+        if(!the_tree) return bigger;
+
+        bigger.allocator.share(allocator);
+
+        splay(key);
+
+        if(comp(the_tree->key, key)) {
+            bigger.the_tree = the_tree->right_child;
+            the_tree->right_child = nullptr;
+            update(the_tree);
+        }
+        else {
+            bigger.the_tree = the_tree;
+            the_tree = the_tree->left_child;
+            bigger.the_tree->left_child = nullptr;
+            update(bigger.the_tree);
+        }
+
+        adopt(the_tree, nullptr);
+        adopt(bigger.the_tree, nullptr);
+
+        return bigger;
+    }
+
+    // assumes every key in other is bigger than the ones in this tree, O(log n) amortized
+    void join(splay_tree &&other) {
+        allocator.absorb(std::move(other.allocator));
+
+        splay_tree_node *right_child = std::exchange(other.the_tree, nullptr);
+        if(!the_tree) {
+            the_tree = right_child;
+            return;
+        }
+
+        splay_biggest();
+
+        the_tree->right_child = right_child;
+        adopt(right_child, the_tree);
+        update(the_tree);
+    }
+
+    // replaces the contents with the (key, value) pairs in [first, last), which must be
+    // sorted by key without duplicates. builds a balanced tree in O(n)
+    template<typename It> void build_from_sorted(It first, It last) {
+        clear();
+
+        const size_t n = static_cast<size_t>(std::distance(first, last));
+        the_tree = build_balanced(first, n);
+    }
+
+    void clear() {
+        if constexpr(
+                Allocator<splay_tree_node>::bulk_reset &&
+                std::is_trivially_destructible_v<K> &&
+                std::is_trivially_destructible_v<V>
+                ) {
+            allocator.reset();
+        }
+        else {
+            // rotate left children up so the tree unrolls into its right spine, no stack needed
+            splay_tree_node *current = the_tree;
+            while(current) {
+                if(splay_tree_node *left_child = current->left_child) {
+                    current->left_child = left_child->right_child;
+                    left_child->right_child = current;
+                    current = left_child;
+                }
+                else {
+                    splay_tree_node *right_child = current->right_child;
+                    allocator.destroy(current);
+                    current = right_child;
+                }
             }
+
+            allocator.reset();
         }
+
+        the_tree = nullptr;
     }
 
     void print() const { if(the_tree) the_tree->print(); }
 
-    ~splay_tree() { delete the_tree; }
+    ~splay_tree() { clear(); }
 };
 
 #endif
@@ -1,9 +1,242 @@
 #include "veb_tree.h"
+#include "y_fast_trie.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+
+// random inserts and removes, every query agrees with std::set
+template<typename Tree, typename T> void check_queries(Tree &tree, std::set<T> &expected, T max_key, size_t num_ops) {
+    std::mt19937_64 gen{max_key};
+    std::uniform_int_distribution<uint64_t> keys{0, max_key};
+
+    for(size_t k=0; k<num_ops; ++k) {
+        const T key = static_cast<T>(keys(gen));
+
+        if(gen() % 3 == 0) {
+            assert(tree.remove(key) == (expected.erase(key) == 1));
+        }
+        else {
+            tree.insert(key);
+            expected.insert(key);
+        }
+
+        assert(tree.size() == expected.size() && tree.empty() == expected.empty());
+        assert(tree.min() == (expected.empty() ? std::nullopt : std::optional<T>{*expected.begin()}));
+        assert(tree.max() == (expected.empty() ? std::nullopt : std::optional<T>{*expected.rbegin()}));
+
+        const T probe = static_cast<T>(keys(gen));
+        assert(tree.contains(probe) == (expected.count(probe) == 1));
+
+        auto it = expected.lower_bound(probe);
+        const auto predecessor = tree.predecessor(probe);
+
+        if(it == expected.begin()) assert(!predecessor);
+        else assert(predecessor && *predecessor == *std::prev(it));
+
+        it = expected.upper_bound(probe);
+        const auto successor = tree.successor(probe);
+
+        if(it == expected.end()) assert(!successor);
+        else assert(successor && *successor == *it);
+    }
+}
+
+template<
+    typename T,
+    size_t bits = sizeof(T) * 8,
+    template<typename, typename, size_t> class Storage = veb_hashed_clusters
+> void check_against_set(T max_key, size_t num_ops) {
+    veb_tree<T, bits, Storage> tree;
+    std::set<T> expected;
+
+    check_queries(tree, expected, max_key, num_ops);
+
+    assert(std::equal(tree.begin(), tree.end(), expected.begin(), expected.end()));
+    assert(std::equal(tree.rbegin(), tree.rend(), expected.rbegin(), expected.rend()));
+}
+
+// bulk loads and batched queries agree with the one key at a time calls, also on a tree that is not empty
+template<typename T, size_t bits, template<typename, typename, size_t> class Storage = veb_hashed_clusters> void check_batches(T max_key) {
+    std::mt19937_64 gen{max_key};
+    std::uniform_int_distribution<uint64_t> keys{0, max_key};
+
+    std::vector<T> first_half(20000), second_half(20000), queries(50000);
+    for(auto &key : first_half) key = static_cast<T>(keys(gen));
+    for(auto &key : second_half) key = static_cast<T>(keys(gen));
+    for(auto &key : queries) key = static_cast<T>(keys(gen));
+    second_half.push_back(0);
+    queries.push_back(std::numeric_limits<T>::max());
+    std::sort(first_half.begin(), first_half.end());
+    std::sort(second_half.begin(), second_half.end());
+    std::sort(queries.begin(), queries.end());
+
+    veb_tree<T, bits, Storage> bulk, one_by_one;
+    bulk.insert_sorted(first_half.begin(), first_half.end());
+    bulk.insert_sorted(second_half.begin(), second_half.end());
+    for(T key : first_half) one_by_one.insert(key);
+    for(T key : second_half) one_by_one.insert(key);
+
+    assert(bulk.size() == one_by_one.size());
+    assert(std::equal(bulk.begin(), bulk.end(), one_by_one.begin(), one_by_one.end()));
+
+    std::vector<std::optional<T>> found(queries.size());
+    bulk.predecessor_batch(queries.begin(), queries.end(), found.begin());
+    for(size_t k=0; k<queries.size(); ++k) assert(found[k] == one_by_one.predecessor(queries[k]));
+}
+
+void benchmark_batches(size_t num_keys) {
+    std::mt19937_64 gen{num_keys};
+    std::vector<uint32_t> keys(num_keys), queries(num_keys);
+    for(auto &key : keys) key = static_cast<uint32_t>(gen());
+    for(auto &key : queries) key = static_cast<uint32_t>(gen());
+    std::sort(keys.begin(), keys.end());
+    std::sort(queries.begin(), queries.end());
+
+    auto seconds_since = [](auto start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<std::optional<uint32_t>> found(num_keys);
+    double insert_seconds, insert_sorted_seconds, predecessor_seconds, predecessor_batch_seconds;
+
+    // one tree at a time, the leaves of both would not fit in memory together at 10^7 keys
+    {
+        veb_tree<uint32_t> one_by_one;
+
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t key : keys) one_by_one.insert(key);
+        insert_seconds = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        for(size_t k=0; k<num_keys; ++k) found[k] = one_by_one.predecessor(queries[k]);
+        predecessor_seconds = seconds_since(start);
+    }
+
+    {
+        veb_tree<uint32_t> bulk;
+
+        auto start = std::chrono::steady_clock::now();
+        bulk.insert_sorted(keys.begin(), keys.end());
+        insert_sorted_seconds = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        bulk.predecessor_batch(queries.begin(), queries.end(), found.begin());
+        predecessor_batch_seconds = seconds_since(start);
+    }
+
+    std::cout << num_keys << " sorted keys in 2^32"
+        << ": insert " << num_keys / insert_seconds / 1e6 << " -> insert_sorted " << num_keys / insert_sorted_seconds / 1e6 << " Mops/s"
+        << ", predecessor " << num_keys / predecessor_seconds / 1e6 << " -> predecessor_batch " << num_keys / predecessor_batch_seconds / 1e6 << " Mops/s" << std::endl;
+}
+
+// memory and throughput against veb_tree, from keys packed into 2^24 to keys spread over all of 2^64
+void benchmark_y_fast(size_t num_keys, size_t universe_bits) {
+    std::mt19937_64 gen{num_keys + universe_bits};
+    std::vector<uint64_t> keys(num_keys);
+    for(auto &key : keys) key = universe_bits == 64 ? gen() : gen() % (uint64_t(1) << universe_bits);
+
+    auto report = [&](const char *name, auto &&tree) {
+        const auto start = std::chrono::steady_clock::now();
+        for(uint64_t key : keys) tree.insert(key);
+        const auto inserted = std::chrono::steady_clock::now();
+
+        size_t found = 0;
+        for(uint64_t key : keys) found += tree.predecessor(key ^ 0x5555).has_value();
+        const auto probed = std::chrono::steady_clock::now();
+        assert(found > 0);
+
+        std::cout << name
+            << ": " << static_cast<double>(tree.memory_usage()) / tree.size() << " bytes per key"
+            << ", insert " << num_keys / std::chrono::duration<double>(inserted - start).count() / 1e6 << " Mops/s"
+            << ", predecessor " << num_keys / std::chrono::duration<double>(probed - inserted).count() / 1e6 << " Mops/s" << std::endl;
+    };
+
+    std::cout << num_keys << " keys in 2^" << universe_bits << std::endl;
+    report("  veb_tree", veb_tree<uint64_t>{});
+    report("  y_fast_trie", y_fast_trie<uint64_t>{});
+}
+
+// keys arriving in descending order all land below the first representative
+void benchmark_y_fast_order(size_t num_keys) {
+    std::mt19937_64 gen{num_keys};
+    std::vector<uint64_t> ascending(num_keys);
+    for(auto &key : ascending) key = gen();
+    std::sort(ascending.begin(), ascending.end());
+
+    std::vector<uint64_t> descending(ascending.rbegin(), ascending.rend()), shuffled = ascending;
+    std::shuffle(shuffled.begin(), shuffled.end(), gen);
+
+    auto report = [&](const char *name, const std::vector<uint64_t> &keys) {
+        y_fast_trie<uint64_t> trie;
+
+        const auto start = std::chrono::steady_clock::now();
+        for(uint64_t key : keys) trie.insert(key);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        assert(trie.size() == keys.size());
+        std::cout << "  " << name << " " << seconds / num_keys * 1e9 << " ns per insert" << std::endl;
+    };
+
+    std::cout << num_keys << " keys into a y_fast_trie" << std::endl;
+    report("ascending", ascending);
+    report("descending", descending);
+    report("random", shuffled);
+}
+
+// the same keys under every cluster storage policy, from sparse to nearly full
+template<size_t bits> void benchmark_storage(size_t num_keys) {
+    std::vector<uint32_t> keys(num_keys);
+    std::mt19937_64 gen{num_keys};
+    for(auto &key : keys) key = static_cast<uint32_t>(gen() % (size_t(1) << bits));
+
+    auto report = [&](const char *name, auto &&tree) {
+        const auto start = std::chrono::steady_clock::now();
+        for(uint32_t key : keys) tree.insert(key);
+        const auto inserted = std::chrono::steady_clock::now();
+
+        size_t found = 0;
+        for(uint32_t key : keys) found += tree.predecessor(key ^ 0x5555).has_value();
+        const auto probed = std::chrono::steady_clock::now();
+        assert(found > 0);
+
+        std::cout << name
+            << ": " << static_cast<double>(tree.memory_usage()) / tree.size() << " bytes per key"
+            << ", insert " << num_keys / std::chrono::duration<double>(inserted - start).count() / 1e6 << " Mops/s"
+            << ", predecessor " << num_keys / std::chrono::duration<double>(probed - inserted).count() / 1e6 << " Mops/s" << std::endl;
+    };
+
+    std::cout << num_keys << " keys in 2^" << bits << std::endl;
+    report("  hashed", veb_tree<uint32_t, bits, veb_hashed_clusters>{});
+    report("  flat", veb_tree<uint32_t, bits, veb_flat_clusters>{});
+}
+
+void benchmark() {
+    for(size_t num_keys : {size_t(1) << 12, size_t(1) << 16, size_t(1) << 20, size_t(1) << 23}) benchmark_storage<24>(num_keys);
+    for(size_t num_keys : {size_t(1) << 16, size_t(1) << 20, size_t(1) << 23}) benchmark_storage<32>(num_keys);
+
+    for(size_t num_keys : {size_t(1) << 16, size_t(1) << 20, size_t(10000000)}) benchmark_batches(num_keys);
+
+    for(size_t universe_bits : {24, 40, 64}) {
+        for(size_t num_keys : {size_t(1) << 12, size_t(1) << 16, size_t(1) << 20}) benchmark_y_fast(num_keys, universe_bits);
+        benchmark_y_fast_order(size_t(1) << 20);
+    }
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && std::string(argv[1]) == "bench") {
+        benchmark();
+        return 0;
+    }
 
-int main() {
     veb_tree<unsigned int> a(0);
 
     for(unsigned int i=1; i<=1<<16; ++i) {
@@ -11,4 +244,70 @@ int main() {
         std::cout << a.predecessor(i+1).value() << std::endl;
         assert(a.predecessor(i+1).value() == i);
     }
+
+    check_against_set<uint8_t>(255, 10000);
+    check_against_set<uint16_t>(5000, 100000);
+    check_against_set<uint32_t>(100000, 100000);
+    check_against_set<uint32_t>(~uint32_t(0), 100000);
+    check_against_set<uint64_t>(~uint64_t(0), 100000);
+
+    // universes narrower than the key type
+    check_against_set<uint32_t, 1>(1, 1000);
+    check_against_set<uint32_t, 13>((1 << 13) - 1, 100000);
+    check_against_set<uint32_t, 24>((1 << 24) - 1, 100000);
+    check_against_set<uint64_t, 40>((uint64_t(1) << 40) - 1, 100000);
+
+    check_against_set<uint32_t, 24, veb_flat_clusters>((1 << 24) - 1, 100000);
+    check_against_set<uint32_t, 16, veb_flat_clusters>((1 << 16) - 1, 100000);
+    check_against_set<uint64_t, 64, veb_flat_clusters>(~uint64_t(0), 100000);
+
+    check_batches<uint16_t, 16>(1000);
+    check_batches<uint32_t, 32>(1 << 20);
+    check_batches<uint32_t, 32>(~uint32_t(0));
+    check_batches<uint32_t, 24, veb_flat_clusters>((1 << 24) - 1);
+    check_batches<uint64_t, 64>(~uint64_t(0));
+
+    // the y-fast trie answers the same queries in O(n) space
+    for(uint64_t max_key : {uint64_t(300), uint64_t(100000), ~uint64_t(0)}) {
+        y_fast_trie<uint64_t> trie;
+        std::set<uint64_t> expected;
+        check_queries(trie, expected, max_key, 200000);
+    }
+
+    // descending keys keep going to the first bucket, below its representative
+    y_fast_trie<uint64_t> falling;
+    for(uint64_t k=0; k<30000; ++k) {
+        const uint64_t key = (100000 - 3*k) << 20;
+        falling.insert(key);
+        assert(falling.min() == key && falling.successor(key - 1) == key);
+        assert(!falling.predecessor(key) && falling.contains(key));
+    }
+    for(uint64_t k=30000; k-- > 0;) {
+        const uint64_t key = (100000 - 3*k) << 20;
+        assert(falling.predecessor(key + 1) == key && falling.successor(key - 1) == key);
+        assert(falling.remove(key) && !falling.contains(key));
+    }
+    assert(falling.empty());
+
+    // 0..191 leave buckets 0..63 and 64..191. draining the first bucket merges it into 143 keys, which
+    // splits again into 49..119 and 120..191, the queries must see through both
+    y_fast_trie<uint64_t> draining;
+    for(uint64_t key=0; key<192; ++key) draining.insert(key);
+    for(uint64_t key=0; key<100; ++key) {
+        assert(draining.remove(key) && draining.min() == key + 1);
+        assert(!draining.predecessor(key + 1) && draining.predecessor(key + 2) == key + 1);
+        assert(draining.predecessor(120) == 119u && draining.successor(119) == 120u && draining.predecessor(1000) == 191u);
+    }
+    assert(draining.size() == 92);
+
+    y_fast_trie<uint8_t> small_trie;
+    std::set<uint8_t> small_expected;
+    check_queries(small_trie, small_expected, uint8_t(255), 20000);
+
+    veb_tree<uint32_t, 20> narrow;
+    narrow.insert(7);
+    assert(narrow.predecessor(1 << 20) == 7u && narrow.predecessor(~0u) == 7u);
+    narrow.remove(1 << 20);
+    narrow.remove(7);
+    assert(!narrow.predecessor(~0u));
 }
@@ -1,239 +1,587 @@
 #ifndef VEB_TREE_H
 #define VEB_TREE_H
 
+#include <algorithm>
 #include <type_traits>
 #include <unordered_map>
-#include <memory>
 #include <optional>
-#include <iostream>
-#include <bitset>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <vector>
 
 
-template<typename T, typename Enable=void> class veb_tree;
+// cluster storage policies. a level with high_bits above the cluster index keeps its clusters in one of these,
+// memory_usage counts the bytes they own including what the clusters own in turn
 
-template<typename T> class veb_tree<T, typename std::enable_if<std::is_integral_v<T> && !std::is_signed_v<T>>::type> {
-    private:
-        static constexpr size_t range = sizeof(T) * 8;
+// clusters in a hash map, memory proportional to the clusters present whatever the universe
+template<typename Key, typename Cluster, size_t high_bits> class veb_hashed_clusters {
+    std::unordered_map<Key, Cluster> clusters;
 
-        struct veb_tree_node {
-            T minimum, maximum;
+    public:
+    Cluster *find(Key c) {
+        auto it = clusters.find(c);
+        return it == clusters.end() ? nullptr : &it->second;
+    }
 
-            veb_tree_node(T item):
-                minimum{item},
-                maximum{item}
-            {}
+    const Cluster *find(Key c) const {
+        auto it = clusters.find(c);
+        return it == clusters.end() ? nullptr : &it->second;
+    }
 
-            virtual std::optional<T> predecessor(T x) const = 0;
-            virtual void insert(T x) = 0;
-            virtual bool remove(T x) = 0;
+    // assumes c has no cluster yet
+    Cluster &emplace(Key c, Key i) { return clusters.try_emplace(c, i).first->second; }
 
-            virtual ~veb_tree_node() {};
-        };
+    void erase(Key c) { clusters.erase(c); }
+
+    // the nodes and buckets of the map, not what the allocator adds around them
+    size_t memory_usage() const {
+        size_t bytes = clusters.bucket_count() * sizeof(void*) + clusters.size() * (sizeof(void*) + sizeof(std::pair<const Key, Cluster>));
+        for(const auto &[c, cluster] : clusters) bytes += cluster.memory_usage();
+
+        return bytes;
+    }
+};
 
-        struct veb_tree_node_small: public veb_tree_node {
-            // only 8 bits
-            static constexpr size_t range = 256;
+// a slot per possible cluster, indexed directly by the high bits. the slots are allocated with the
+// first cluster, so this only pays off for small universes, levels with more than 2^16 slots stay hashed
+template<typename Key, typename Cluster, size_t high_bits> class veb_flat_clusters {
+    std::vector<std::unique_ptr<Cluster>> slots;
 
-            std::bitset<range> the_node;
+    public:
+    Cluster *find(Key c) { return slots.empty() ? nullptr : slots[c].get(); }
+    const Cluster *find(Key c) const { return slots.empty() ? nullptr : slots[c].get(); }
+
+    Cluster &emplace(Key c, Key i) {
+        if(slots.empty()) slots.resize(size_t(1) << high_bits);
+
+        slots[c] = std::make_unique<Cluster>(i);
+        return *slots[c];
+    }
+
+    void erase(Key c) { slots[c].reset(); }
+
+    size_t memory_usage() const {
+        size_t bytes = slots.capacity() * sizeof(std::unique_ptr<Cluster>);
+        for(const auto &slot : slots) {
+            if(slot) bytes += sizeof(Cluster) + slot->memory_usage();
+        }
 
-            veb_tree_node_small(T item):
-                veb_tree_node{item},
-                the_node{}
+        return bytes;
+    }
+};
+
+
+// the universe is [0, 2^bits), every level is a concrete type picked at compile time,
+// so there is no virtual dispatch and the whole recursion can be inlined
+template<
+    typename T,
+    size_t bits = sizeof(T) * 8,
+    template<typename, typename, size_t> class Storage = veb_hashed_clusters,
+    typename Enable=void
+> class veb_tree;
+
+template<typename T, size_t bits, template<typename, typename, size_t> class Storage> class veb_tree<T, bits, Storage, typename std::enable_if<std::is_integral_v<T> && !std::is_signed_v<T> && (bits > 0) && (bits <= sizeof(T) * 8)>::type> {
+    private:
+        static constexpr size_t leaf_bits = 12;
+        static constexpr size_t max_indexed_bits = 16;
+        static constexpr T max_key = bits == sizeof(T) * 8 ? std::numeric_limits<T>::max() : static_cast<T>((T(1) << bits) - 1);
+
+        template<size_t num_bits> struct veb_tree_leaf;
+        template<size_t num_bits> struct veb_tree_node_large;
+
+        template<size_t num_bits> using node_t = std::conditional_t<
+            num_bits <= leaf_bits,
+            veb_tree_leaf<num_bits>,
+            veb_tree_node_large<num_bits>
+        >;
+
+        // the base case, up to 4096 keys in 64 words. a summary word marks the words that are not empty,
+        // so every query is a mask and a bit scan on the summary, then one on a single word
+        template<size_t num_bits> struct veb_tree_leaf {
+            static constexpr size_t num_words = ((size_t(1) << num_bits) + 63) / 64;
+
+            uint64_t summary_word;
+            std::array<uint64_t, num_words> words;
+
+            veb_tree_leaf(T item):
+                summary_word{0},
+                words{}
             {
-                std::cout << "creating " << std::bitset<8>(item) << " into small node" << std::endl;
-                the_node[item] = true;
+                insert(item);
             }
 
-            std::optional<T> predecessor(T x) const override {
-                while(x-- > 0) {
-                    if(the_node[x]) return x;
-                }
+            static size_t lowest(uint64_t word) { return __builtin_ctzll(word); }
+            static size_t highest(uint64_t word) { return 63 - __builtin_clzll(word); }
+
+            // the bits strictly below and strictly above bit
+            static uint64_t below(size_t bit) { return (uint64_t(1) << bit) - 1; }
+            static uint64_t above(size_t bit) { return ~uint64_t(1) << bit; }
+
+            T min() const {
+                const size_t w = lowest(summary_word);
+                return static_cast<T>(w * 64 + lowest(words[w]));
+            }
 
-                return {};
+            T max() const {
+                const size_t w = highest(summary_word);
+                return static_cast<T>(w * 64 + highest(words[w]));
             }
 
-            void insert(T x) override {
-                std::cout << "inserting " << std::bitset<8>(x) << " into small node min max " << std::bitset<8>(this->minimum) << ',' << std::bitset<8>(this->maximum) << std::endl;
-                if(x < this->minimum) {
-                    this->minimum = x;
+            std::optional<T> predecessor(T x) const {
+                const size_t w = x / 64;
+
+                if(const uint64_t rest = words[w] & below(x % 64)) return static_cast<T>(w * 64 + highest(rest));
+                else if(const uint64_t rest = summary_word & below(w)) {
+                    const size_t v = highest(rest);
+                    return static_cast<T>(v * 64 + highest(words[v]));
                 }
-                else if(x > this->maximum) {
-                    this->maximum = x;
+                else return {};
+            }
+
+            std::optional<T> successor(T x) const {
+                const size_t w = x / 64;
+
+                if(const uint64_t rest = words[w] & above(x % 64)) return static_cast<T>(w * 64 + lowest(rest));
+                else if(const uint64_t rest = summary_word & above(w)) {
+                    const size_t v = lowest(rest);
+                    return static_cast<T>(v * 64 + lowest(words[v]));
                 }
+                else return {};
+            }
 
-                the_node[x] = true;
+            bool contains(T x) const {
+                return words[x / 64] >> (x % 64) & 1;
             }
 
-            bool remove(T x) override {
-                if(!the_node[x]) return false;
-                else if(this->minimum == this->maximum) return true;
+            // true if x was not present yet
+            bool insert(T x) {
+                const bool added = !contains(x);
 
-                the_node[x] = false;
+                words[x / 64] |= uint64_t(1) << (x % 64);
+                summary_word |= uint64_t(1) << (x / 64);
 
-                if(x == this->minimum) {
-                    while(x++ < range) {
-                        if(the_node[x]) {
-                            this->minimum = x;
-                            break;
-                        }
-                    }
-                }
-                else if(x == this->maximum) {
-                    while(x-- > 0) {
-                        if(the_node[x]) {
-                            this->maximum = x;
-                            break;
-                        }
-                    }
-                }
+                return added;
+            }
 
-                return false;
+            // the number of keys that were not present yet
+            template<typename It> size_t insert_sorted(It first, It last) {
+                size_t num_added = 0;
+                for(; first != last; ++first) num_added += insert(*first);
+
+                return num_added;
             }
 
-            ~veb_tree_node_small() {}
+            template<typename It, typename Func> void predecessor_batch(It first, It last, Func &&emit) const {
+                for(; first != last; ++first) emit(predecessor(*first));
+            }
+
+            size_t memory_usage() const { return 0; }
+
+            // true once the leaf is empty
+            bool remove(T x) {
+                const size_t w = x / 64;
+
+                words[w] &= ~(uint64_t(1) << (x % 64));
+                if(!words[w]) summary_word &= ~(uint64_t(1) << w);
+
+                return !summary_word;
+            }
         };
 
-        struct veb_tree_node_large: public veb_tree_node {
-            const size_t num_bits;
-            const T half_mask;
+        // the minimum is kept here only, every other key lives in the cluster named by its high bits.
+        // the low bits index into a cluster, once the rest fits a leaf as well both halves are leaves
+        template<size_t num_bits> struct veb_tree_node_large {
+            static constexpr size_t low_bits = num_bits <= 2*leaf_bits ? leaf_bits : num_bits/2;
+            static constexpr T low_mask = static_cast<T>((T(1) << low_bits) - 1);
 
-            std::unordered_map<T, std::unique_ptr<veb_tree_node>> clusters;
-            std::unique_ptr<veb_tree_node> summary;
+            static constexpr size_t high_bits = num_bits - low_bits;
+
+            using cluster_t = node_t<low_bits>;
+            using summary_t = node_t<high_bits>;
+            using storage_t = std::conditional_t<
+                high_bits <= max_indexed_bits,
+                Storage<T, cluster_t, high_bits>,
+                veb_hashed_clusters<T, cluster_t, high_bits>
+            >;
+
+            T minimum, maximum;
 
-            veb_tree_node_large(size_t num_bits, T item):
-                veb_tree_node{item},
-                num_bits{num_bits},
-                half_mask{(T(1) << num_bits/2) - 1},
+            storage_t clusters;
+            std::optional<summary_t> summary;
+
+            veb_tree_node_large(T item):
+                minimum{item},
+                maximum{item},
                 clusters{},
                 summary{}
-            {
-                std::cout << "creating " << std::bitset<range>(item) << " into large node of range " << num_bits << std::endl;
+            {}
+
+            T min() const { return minimum; }
+            T max() const { return maximum; }
+
+            std::optional<T> predecessor(T x) const {
+                const auto c = cluster_of(x);
+                const auto i = id_of(x);
+
+                if(x <= minimum) return {};
+                else if(auto cluster = clusters.find(c); cluster && i>cluster->min()) {
+                    return combine(c, *cluster->predecessor(i));
+                }
+                else if(auto smaller_cluster = summary ? summary->predecessor(c) : std::nullopt) {
+                    return combine(*smaller_cluster, clusters.find(*smaller_cluster)->max());
+                }
+                else {
+                    return minimum;
+                }
             }
 
-            std::optional<T> predecessor(T x) const override {
+            std::optional<T> successor(T x) const {
                 const auto c = cluster_of(x);
                 const auto i = id_of(x);
 
-                if(x <= this->minimum) return {};
-                else if(auto it = clusters.find(c); it!=clusters.end() && i>it->second->minimum) {
-                    return combine(c, it->second->predecessor(i).value()); 
+                if(x < minimum) return minimum;
+                else if(auto cluster = clusters.find(c); cluster && i<cluster->max()) {
+                    return combine(c, *cluster->successor(i));
+                }
+                else if(auto bigger_cluster = summary ? summary->successor(c) : std::nullopt) {
+                    return combine(*bigger_cluster, clusters.find(*bigger_cluster)->min());
                 }
                 else {
-                    if(summary) {
-                        const auto bigger_cluster = summary->predecessor(c).value();
-                        return combine(bigger_cluster, clusters.at(bigger_cluster)->maximum);
-                    }
-                    else {
-                        return this->minimum;
-                    }
+                    return {};
                 }
             }
 
-            void insert(T x) override {
-                std::cout << "inserting " << std::bitset<range>(x) << " into large node of range " << num_bits << " min max: " << std::bitset<range>(this->minimum) << ',' << std::bitset<range>(this->maximum) << std::endl;
-                if(x < this->minimum) {
-                    std::swap(this->minimum, x);
+            bool contains(T x) const {
+                if(x == minimum) return true;
+
+                auto cluster = clusters.find(cluster_of(x));
+                return cluster && cluster->contains(id_of(x));
+            }
+
+            size_t memory_usage() const {
+                return clusters.memory_usage() + (summary ? summary->memory_usage() : 0);
+            }
+
+            // true if x was not present yet
+            bool insert(T x) {
+                if(x == minimum) {
+                    return false;
+                }
+                else if(x < minimum) {
+                    std::swap(minimum, x);
                 }
-                else if(x > this->maximum) {
-                    this->maximum = x;
+                else if(x > maximum) {
+                    maximum = x;
                 }
 
                 const auto c = cluster_of(x);
                 const auto i = id_of(x);
 
-                if(auto it = clusters.find(c); it == clusters.end()) {
-                    std::cout << "not seen " << std::bitset<range>(x) << " in large node of range " << num_bits << std::endl;
+                if(auto cluster = clusters.find(c); !cluster) {
+                    if(!summary) summary.emplace(c);
+                    else summary->insert(c);
 
-                    if(!summary) {
-                        if(num_bits > 16) {
-                            summary = std::make_unique<veb_tree_node_large>(num_bits/2, c);
-                        }
-                        else {
-                            summary = std::make_unique<veb_tree_node_small>(c);
-                        }
+                    clusters.emplace(c, i);
+                    return true;
+                }
+                else {
+                    return cluster->insert(i);
+                }
+            }
+
+            // keys are grouped by cluster, so a cluster is looked up once per group rather than once per key.
+            // new clusters are built whole, then handed to the summary in one sorted batch.
+            // assumes [first, last) is sorted, returns the number of keys that were not present yet
+            template<typename It> size_t insert_sorted(It first, It last) {
+                size_t num_added = 0;
+
+                if(first != last && *first < minimum) {
+                    // the old minimum moves down into the clusters like any other key
+                    const T old_minimum = minimum;
+                    minimum = *first;
+                    ++first;
+                    ++num_added;
+
+                    insert(old_minimum);
+                }
+
+                std::vector<T> ids, new_clusters;
+
+                while(first != last) {
+                    if(*first == minimum) {
+                        ++first;
+                        continue;
                     }
-                    else{
-                        summary->insert(c);
+
+                    const auto c = cluster_of(*first);
+
+                    ids.clear();
+                    for(; first != last && cluster_of(*first) == c; ++first) {
+                        ids.push_back(id_of(*first));
+                        maximum = std::max(maximum, *first);
                     }
 
-                    if(num_bits > 16) {
-                        clusters.emplace(c, std::make_unique<veb_tree_node_large>(num_bits/2, i));
+                    if(auto cluster = clusters.find(c)) {
+                        num_added += cluster->insert_sorted(ids.begin(), ids.end());
                     }
                     else {
-                        clusters.emplace(c, std::make_unique<veb_tree_node_small>(i));
+                        num_added += 1 + clusters.emplace(c, ids.front()).insert_sorted(ids.begin() + 1, ids.end());
+                        new_clusters.push_back(c);
                     }
                 }
-                else {
-                    it->second->insert(i);
+
+                if(!new_clusters.empty()) {
+                    if(!summary) {
+                        summary.emplace(new_clusters.front());
+                        summary->insert_sorted(new_clusters.begin() + 1, new_clusters.end());
+                    }
+                    else {
+                        summary->insert_sorted(new_clusters.begin(), new_clusters.end());
+                    }
                 }
+
+                return num_added;
             }
 
-            bool remove(T x) override {
-                const auto c = cluster_of(x);
-                const auto i = id_of(x);
+            // neighbouring queries mostly fall into the same cluster, which is then looked up and has its
+            // fallback answer from the summary worked out once for all of them. assumes [first, last) is sorted
+            template<typename It, typename Func> void predecessor_batch(It first, It last, Func &&emit) const {
+                for(; first != last && *first <= minimum; ++first) emit(std::nullopt);
 
-                if(x == this->minimum) {
-                    if(this->minimum == this->maximum) return true;
-                    else if(auto it = clusters.find(summary->minimum); it != clusters.end()) {
-                        this->minimum = combine(summary->minimum, it->second->minimum);
-                        if(it->second->remove(it->second->minimum)) {
-                            clusters.erase(it);
-                            if(summary->remove(summary->minimum)) summary.reset();
-                        }
-                    }
-                }
-                else {
-                    if(auto it = clusters.find(c); it != clusters.end()) {
-                        if(it->second->remove(i)){
-                            clusters.erase(it);
-                            if(summary->remove(c)) summary.reset();
+                std::vector<T> ids;
+
+                while(first != last) {
+                    const auto c = cluster_of(*first);
+                    const auto cluster = clusters.find(c);
+
+                    // the answer for queries at or below the minimum of their cluster
+                    std::optional<T> fallback;
+                    bool has_fallback = false;
+
+                    ids.clear();
+                    for(; first != last && cluster_of(*first) == c; ++first) {
+                        const auto i = id_of(*first);
+
+                        if(cluster && i > cluster->min()) {
+                            ids.push_back(i);
                         }
+                        else {
+                            if(!has_fallback) {
+                                auto smaller_cluster = summary ? summary->predecessor(c) : std::nullopt;
+                                fallback = smaller_cluster ? combine(*smaller_cluster, clusters.find(*smaller_cluster)->max()) : minimum;
+                                has_fallback = true;
+                            }
 
-                        if(x == this->maximum) {
-                            if(summary) this->maximum = combine(summary->maximum, clusters.at(summary->maximum)->maximum);
-                            else this->maximum = this->minimum;
+                            emit(fallback);
                         }
                     }
+
+                    if(!ids.empty()) {
+                        cluster->predecessor_batch(ids.begin(), ids.end(), [&emit, c](std::optional<T> found) {
+                            emit(combine(c, *found));
+                        });
+                    }
+                }
+            }
+
+            // true once the node is empty, removing a key that is not present changes nothing
+            bool remove(T x) {
+                if(x == minimum) {
+                    if(!summary) return true;
+
+                    // the smallest key in the clusters moves up to become the minimum
+                    const auto c = summary->min();
+                    x = combine(c, clusters.find(c)->min());
+                    minimum = x;
                 }
 
+                const auto c = cluster_of(x);
+                auto cluster = clusters.find(c);
+                if(!cluster) return false;
+
+                if(cluster->remove(id_of(x))) {
+                    clusters.erase(c);
+                    if(summary->remove(c)) summary.reset();
+                }
+
+                if(x == maximum) {
+                    if(summary) maximum = combine(summary->max(), clusters.find(summary->max())->max());
+                    else maximum = minimum;
+                }
 
                 return false;
             }
 
-            ~veb_tree_node_large() {}
-
-            private:
-            T cluster_of(T item) const { return item >> num_bits/2; }
-            T id_of(T item) const { return item & half_mask; }
-            T combine(T c, T i) const { return c << num_bits/2 | i; }
+            static T cluster_of(T item) { return static_cast<T>(item >> low_bits); }
+            static T id_of(T item) { return item & low_mask; }
+            static T combine(T c, T i) { return static_cast<T>(T(c) << low_bits | i); }
         };
 
-        std::unique_ptr<veb_tree_node> the_tree;
+        std::optional<node_t<bits>> the_tree;
+        size_t num_keys;
 
     public:
-        veb_tree(T x):
-            the_tree{
-                range > 16 ?
-                    static_cast<std::unique_ptr<veb_tree_node>>(std::make_unique<veb_tree_node_large>(range, x)) :
-                    static_cast<std::unique_ptr<veb_tree_node>>(std::make_unique<veb_tree_node_small>(x))
+        // walks the keys in order, every step is a successor or predecessor query.
+        // dereferencing yields the key by value, the iterator holds no node to point into
+        class const_iterator {
+            const veb_tree *tree;
+            std::optional<T> current;
+
+            friend class veb_tree;
+
+            const_iterator(const veb_tree *tree, std::optional<T> current):
+                tree{tree},
+                current{current}
+            {}
+
+            public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = T;
+
+            const_iterator():
+                tree{nullptr},
+                current{}
+            {}
+
+            T operator*() const { return *current; }
+
+            const_iterator &operator++() {
+                current = tree->successor(*current);
+                return *this;
             }
+
+            const_iterator operator++(int) {
+                const_iterator old = *this;
+                ++*this;
+                return old;
+            }
+
+            // stepping back from end lands on the maximum
+            const_iterator &operator--() {
+                current = current ? tree->predecessor(*current) : tree->max();
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator old = *this;
+                --*this;
+                return old;
+            }
+
+            bool operator==(const const_iterator &other) const { return current == other.current; }
+            bool operator!=(const const_iterator &other) const { return current != other.current; }
+        };
+
+        using iterator = const_iterator;
+        using reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        veb_tree(T x):
+            the_tree{std::in_place, x},
+            num_keys{1}
+        {}
+        veb_tree():
+            the_tree{},
+            num_keys{0}
         {}
-        veb_tree() {}
 
-        std::optional<T> predecessor(T x) const {
-            if(the_tree) return the_tree->predecessor(x);
+        // bytes held by the tree, its clusters and summaries at every level
+        size_t memory_usage() const {
+            return sizeof(*this) + (the_tree ? the_tree->memory_usage() : 0);
+        }
+
+        bool empty() const { return num_keys == 0; }
+        size_t size() const { return num_keys; }
+
+        std::optional<T> min() const {
+            if(the_tree) return the_tree->min();
             else return {};
         }
 
+        std::optional<T> max() const {
+            if(the_tree) return the_tree->max();
+            else return {};
+        }
+
+        bool contains(T x) const {
+            return the_tree && x <= max_key && the_tree->contains(x);
+        }
+
+        // the largest key strictly smaller than x
+        std::optional<T> predecessor(T x) const {
+            if(!the_tree) return {};
+            else if(x > max_key) return the_tree->max();
+            else return the_tree->predecessor(x);
+        }
+
+        // the smallest key strictly bigger than x
+        std::optional<T> successor(T x) const {
+            if(!the_tree || x > max_key) return {};
+            else return the_tree->successor(x);
+        }
+
+        // assumes x < 2^bits
         void insert(T x) {
-            if(the_tree) the_tree->insert(x);
-            else if(range > 16) the_tree = std::make_unique<veb_tree_node_large>(range, x);
-            else the_tree = std::make_unique<veb_tree_node_small>(x);
+            if(!the_tree) {
+                the_tree.emplace(x);
+                ++num_keys;
+            }
+            else if(the_tree->insert(x)) {
+                ++num_keys;
+            }
         }
 
-        void remove(T x) {
-            if(the_tree && the_tree->remove(x)) the_tree.reset();
+        // builds every cluster and summary in one pass per level instead of descending once per key.
+        // assumes [first, last) is sorted and every key < 2^bits, duplicates are fine
+        template<typename It> void insert_sorted(It first, It last) {
+            if(first == last) return;
+
+            if(!the_tree) {
+                the_tree.emplace(*first);
+                ++num_keys;
+                ++first;
+            }
+
+            num_keys += the_tree->insert_sorted(first, last);
         }
+
+        // writes the predecessor of every query to out, as predecessor would.
+        // assumes [first, last) is sorted, so queries sharing a path down the tree are answered together
+        template<typename It, typename Out> void predecessor_batch(It first, It last, Out out) const {
+            if(!the_tree) {
+                for(; first != last; ++first, ++out) *out = std::nullopt;
+                return;
+            }
+
+            const It beyond = std::partition_point(first, last, [](T x) { return x <= max_key; });
+
+            the_tree->predecessor_batch(first, beyond, [&out](std::optional<T> found) {
+                *out = found;
+                ++out;
+            });
+
+            for(first=beyond; first != last; ++first, ++out) *out = the_tree->max();
+        }
+
+        // true if x was present
+        bool remove(T x) {
+            if(!contains(x)) return false;
+
+            if(the_tree->remove(x)) the_tree.reset();
+            --num_keys;
+
+            return true;
+        }
+
+        const_iterator begin() const { return {this, min()}; }
+        const_iterator end() const { return {this, std::nullopt}; }
+        reverse_iterator rbegin() const { return reverse_iterator{end()}; }
+        reverse_iterator rend() const { return reverse_iterator{begin()}; }
 };
 
 #endif
@@ -0,0 +1,280 @@
+#ifndef Y_FAST_TRIE_H
+#define Y_FAST_TRIE_H
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// keys are kept in buckets of about bits keys each, every bucket is a std::set named by a representative
+// bigger than every key of the bucket before it and no bigger than its own keys, except that the first
+// bucket also takes the keys below its representative. an x-fast trie over the representatives, one
+// hash map of prefixes per level, finds the bucket of a key in O(log log U) by binary searching the levels
+// for the longest prefix present. with n / bits buckets and bits levels that is O(n) space.
+// a bucket of at most 2 * bits keys is searched and updated in O(log log U), and the trie itself only
+// changes when a bucket is split or merged, once every Omega(bits) updates, so updates are O(log log U)
+// amortized, at the cost of a tree node per key instead of a packed array
+template<typename T, typename Enable=void> class y_fast_trie;
+
+template<typename T> class y_fast_trie<T, typename std::enable_if<std::is_integral_v<T> && !std::is_signed_v<T>>::type> {
+    private:
+        static constexpr size_t bits = sizeof(T) * 8;
+        static constexpr size_t max_bucket = 2 * bits;
+        static constexpr size_t min_bucket = bits / 4;
+
+        // the smallest and biggest representative below a prefix
+        struct x_fast_node {
+            T minimum, maximum;
+        };
+
+        // the leaves of the x-fast trie, linked in order
+        struct bucket {
+            std::set<T> keys;
+            std::optional<T> prev, next;
+        };
+
+        std::vector<std::unordered_map<T, x_fast_node>> levels;
+        std::unordered_map<T, bucket> buckets;
+        size_t num_keys;
+
+        static T prefix(T x, size_t level) {
+            return level == 0 ? 0 : static_cast<T>(x >> (bits - level));
+        }
+
+        static bool bit_below(T x, size_t level) {
+            return x >> (bits - level - 1) & 1;
+        }
+
+        // the representatives below the prefix at level, a leaf is its own representative
+        std::optional<x_fast_node> node_at(size_t level, T p) const {
+            if(level == bits) {
+                if(buckets.count(p)) return x_fast_node{p, p};
+                else return {};
+            }
+
+            auto it = levels[level].find(p);
+            if(it == levels[level].end()) return {};
+            else return it->second;
+        }
+
+        // the biggest representative not bigger than x
+        std::optional<T> floor_rep(T x) const {
+            if(buckets.empty()) return {};
+            else if(buckets.count(x)) return x;
+
+            // level lo has x's prefix and level hi does not
+            size_t lo = 0, hi = bits;
+            while(hi - lo > 1) {
+                const size_t mid = (lo + hi) / 2;
+
+                if(levels[mid].count(prefix(x, mid))) lo = mid;
+                else hi = mid;
+            }
+
+            const T p = prefix(x, lo);
+
+            // only the other child of the deepest shared prefix exists, it is wholly below or above x
+            if(bit_below(x, lo)) return node_at(lo + 1, static_cast<T>(p << 1))->maximum;
+            else return buckets.at(node_at(lo + 1, static_cast<T>(p << 1 | 1))->minimum).prev;
+        }
+
+        T first_rep() const {
+            return levels[0].at(0).minimum;
+        }
+
+        void add_rep(T r, std::set<T> &&keys) {
+            const auto prev = floor_rep(r);
+            const auto next = prev ? buckets.at(*prev).next : (buckets.empty() ? std::nullopt : std::optional<T>{first_rep()});
+
+            buckets.emplace(r, bucket{std::move(keys), prev, next});
+            if(prev) buckets.at(*prev).next = r;
+            if(next) buckets.at(*next).prev = r;
+
+            for(size_t level=0; level<bits; ++level) {
+                auto [it, fresh] = levels[level].try_emplace(prefix(r, level), x_fast_node{r, r});
+
+                if(!fresh) {
+                    it->second.minimum = std::min(it->second.minimum, r);
+                    it->second.maximum = std::max(it->second.maximum, r);
+                }
+            }
+        }
+
+        void remove_rep(T r) {
+            const bucket &gone = buckets.at(r);
+            if(gone.prev) buckets.at(*gone.prev).next = gone.next;
+            if(gone.next) buckets.at(*gone.next).prev = gone.prev;
+            buckets.erase(r);
+
+            for(size_t level=bits; level-- > 0;) {
+                const T p = prefix(r, level);
+                const auto left = node_at(level + 1, static_cast<T>(p << 1));
+                const auto right = node_at(level + 1, static_cast<T>(p << 1 | 1));
+
+                if(!left && !right) {
+                    levels[level].erase(p);
+                }
+                else {
+                    x_fast_node &node = levels[level].at(p);
+                    node.minimum = left ? left->minimum : right->minimum;
+                    node.maximum = right ? right->maximum : left->maximum;
+                }
+            }
+        }
+
+        // the bucket a key belongs to, the first one for keys below every representative. assumes non empty
+        T home_rep(T x) const {
+            const auto r = floor_rep(x);
+            return r ? *r : first_rep();
+        }
+
+        // the upper half moves to a bucket of its own, named by its smallest key. the first bucket is
+        // renamed after its smallest key beforehand, keys below its representative may reach the upper half.
+        // the nodes are relinked rather than copied, appending each at the end of the new tree
+        void split(T r) {
+            if(*buckets.at(r).keys.begin() < r) {
+                std::set<T> keys = std::move(buckets.at(r).keys);
+
+                remove_rep(r);
+                r = *keys.begin();
+                add_rep(r, std::move(keys));
+            }
+
+            std::set<T> &keys = buckets.at(r).keys;
+            std::set<T> upper;
+            for(auto it = std::next(keys.begin(), keys.size() / 2); it != keys.end();) {
+                upper.insert(upper.end(), keys.extract(it++));
+            }
+
+            const T upper_rep = *upper.begin();
+            add_rep(upper_rep, std::move(upper));
+        }
+
+        // folds a small bucket into a neighbour, splitting again if that makes it too big
+        void merge(T r) {
+            bucket &small = buckets.at(r);
+
+            if(small.next) {
+                const T next = *small.next;
+                small.keys.merge(buckets.at(next).keys);
+
+                remove_rep(next);
+                if(buckets.at(r).keys.size() > max_bucket) split(r);
+            }
+            else if(small.prev) {
+                const T prev = *small.prev;
+                buckets.at(prev).keys.merge(small.keys);
+
+                remove_rep(r);
+                if(buckets.at(prev).keys.size() > max_bucket) split(prev);
+            }
+            else if(small.keys.empty()) {
+                remove_rep(r);
+            }
+        }
+
+    public:
+        y_fast_trie():
+            levels(bits),
+            buckets{},
+            num_keys{0}
+        {}
+
+        bool empty() const { return num_keys == 0; }
+        size_t size() const { return num_keys; }
+
+        std::optional<T> min() const {
+            if(buckets.empty()) return {};
+            else return *buckets.at(first_rep()).keys.begin();
+        }
+
+        std::optional<T> max() const {
+            if(buckets.empty()) return {};
+            else return *buckets.at(levels[0].at(0).maximum).keys.rbegin();
+        }
+
+        bool contains(T x) const {
+            if(buckets.empty()) return false;
+
+            return buckets.at(home_rep(x)).keys.count(x) == 1;
+        }
+
+        // the largest key strictly smaller than x
+        std::optional<T> predecessor(T x) const {
+            if(buckets.empty()) return {};
+
+            const bucket &home = buckets.at(home_rep(x));
+            auto it = home.keys.lower_bound(x);
+
+            if(it != home.keys.begin()) return *std::prev(it);
+            else if(home.prev) return *buckets.at(*home.prev).keys.rbegin();
+            else return {};
+        }
+
+        // the smallest key strictly bigger than x
+        std::optional<T> successor(T x) const {
+            if(buckets.empty()) return {};
+
+            const bucket &home = buckets.at(home_rep(x));
+            auto it = home.keys.upper_bound(x);
+
+            if(it != home.keys.end()) return *it;
+            else if(home.next) return *buckets.at(*home.next).keys.begin();
+            else return {};
+        }
+
+        void insert(T x) {
+            if(buckets.empty()) {
+                add_rep(x, {x});
+                ++num_keys;
+                return;
+            }
+
+            const T r = home_rep(x);
+
+            std::set<T> &keys = buckets.at(r).keys;
+            if(!keys.insert(x).second) return;
+
+            ++num_keys;
+
+            if(keys.size() > max_bucket) split(r);
+        }
+
+        // true if x was present
+        bool remove(T x) {
+            if(buckets.empty()) return false;
+
+            const T r = home_rep(x);
+
+            std::set<T> &keys = buckets.at(r).keys;
+            if(keys.erase(x) == 0) return false;
+
+            --num_keys;
+
+            if(keys.size() < min_bucket) merge(r);
+
+            return true;
+        }
+
+        // the nodes and buckets of every map and the tree nodes of every bucket, not what the allocator adds around them
+        size_t memory_usage() const {
+            size_t bytes = sizeof(*this) + levels.capacity() * sizeof(levels[0]);
+
+            for(const auto &level : levels) {
+                bytes += level.bucket_count() * sizeof(void*) + level.size() * (sizeof(void*) + sizeof(std::pair<const T, x_fast_node>));
+            }
+
+            bytes += buckets.bucket_count() * sizeof(void*) + buckets.size() * (sizeof(void*) + sizeof(std::pair<const T, bucket>));
+            // a tree node is three links and a colour padded to a word, then the key
+            for(const auto &[r, the_bucket] : buckets) bytes += the_bucket.keys.size() * (4 * sizeof(void*) + sizeof(T));
+
+            return bytes;
+        }
+};
+
+#endif